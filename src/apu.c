@@ -1,6 +1,10 @@
 #include "apu.h"
 #include "cpu.h"
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_init.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const uint8_t pulse_duty[4] = { 0x01, 0x03, 0x0F, 0xFC };
@@ -9,102 +13,509 @@ static const uint8_t triangle_seq[32] = { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5,
 static const uint16_t noise_period[16] = { 4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068 };
 static const uint16_t dmc_period[16] = { 428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54 };
 
-static inline float dc_block(_apu* apu, float x) {
-    float y = x - apu->dc_prev_in + 0.995f * apu->dc_prev_out;
-    apu->dc_prev_in = x;
-    apu->dc_prev_out = y;
-    return y;
+static int32_t pulse_table[31];
+static int32_t tnd_table[203];
+
+// 95.52 / (8128 / n + 100) and 163.67 / (24329 / n + 100), in Q15
+static void build_mix_tables(void) {
+    for (uint64_t n = 0; n < 31; n++) {
+        uint64_t den = 100 * (8128 + 100 * n);
+        pulse_table[n] = (int32_t)((9552 * n * APU_OUTPUT_ONE + den / 2) / den);
+    }
+
+    for (uint64_t n = 0; n < 203; n++) {
+        uint64_t den = 100 * (24329 + 100 * n);
+        tnd_table[n] = (int32_t)((16367 * n * APU_OUTPUT_ONE + den / 2) / den);
+    }
 }
 
-static inline float ramp_gain(float current, int gate, int* ramp_counter) {
-    float target = gate ? 1.0f : 0.0f;
-    if (*ramp_counter <= 0) {
-        if (current != target) {
-            *ramp_counter = RAMP_SAMPLES;
-        } else {
-            return current;
+static void noise_shift(_noise* n) {
+    uint16_t feedback;
+    if (n->mode) {
+        feedback = ((n->shift_reg & 0x0001) ^ ((n->shift_reg & 0x0040) >> 6));
+    } else {
+        feedback = ((n->shift_reg & 0x0001) ^ ((n->shift_reg & 0x0002) >> 1));
+    }
+    n->shift_reg >>= 1;
+    if (feedback) {
+        n->shift_reg |= 0x4000;
+    } else {
+        n->shift_reg &= ~0x4000;
+    }
+}
+
+static void update_stems(_apu_stems* stems, uint32_t time, const int32_t* levels) {
+    for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+        int32_t delta = levels[c] - stems->amplitude[c];
+        if (delta) {
+            blip_add_delta(&stems->blip[c], time, delta);
+            stems->amplitude[c] = levels[c];
         }
     }
-    float step = (target - current) / (float)*ramp_counter;
-    current += step;
-    (*ramp_counter)--;
-    return current;
 }
 
-float mix(float pulse1, float pulse2, float triangle, float noise, float dmc) {
-    float pulse_sum = pulse1 + pulse2;
-    float tnd_sum = triangle / 8227.0f + noise / 12241.0f + dmc / 22638.0f;
+static void update_output(_apu* apu) {
+    if (apu->audio_off) return;
 
-    float pulse_out = 0.0f;
-    if (pulse_sum > 0.0f) {
-        pulse_out = 95.88f / (8128.0f / pulse_sum + 100.0f);
+    uint8_t pulse1 = sample_pulse(&apu->pulse1);
+    uint8_t pulse2 = sample_pulse(&apu->pulse2);
+    uint8_t triangle = sample_triangle(&apu->triangle);
+    uint8_t noise = sample_noise(&apu->noise);
+    uint8_t dmc = sample_dmc(&apu->dmc);
+
+    int32_t out = pulse_table[pulse1 + pulse2] + tnd_table[3 * triangle + 2 * noise + dmc];
+
+    int32_t delta = out - apu->amplitude;
+    if (delta) {
+        blip_add_delta(&apu->blip, apu->blip_time, delta);
+        apu->amplitude = out;
     }
 
-    float tnd_out = 0.0f;
-    if (tnd_sum > 0.0f) {
-        tnd_out = 159.79f / (1.0f / tnd_sum + 100.0f);
+    if (apu->stems) {
+        const int32_t levels[AUDIO_STEMS] = {
+            pulse_table[pulse1],
+            pulse_table[pulse2],
+            tnd_table[3 * triangle],
+            tnd_table[2 * noise],
+            tnd_table[dmc],
+        };
+        update_stems(apu->stems, apu->blip_time, levels);
     }
+}
 
-    return pulse_out + tnd_out;
+static uint32_t mix_rate(uint32_t rate, _audio_quality quality) {
+    return quality == AUDIO_QUALITY_DIRECT ? rate : CPU_FREQ_NTSC / APU_DECIMATION;
 }
 
-void open_audio_stream(_apu* apu) {
-    if (apu->audio_stream) return;
+static CNES_RESULT init_stems(_apu_stems* stems, uint32_t rate, _audio_quality quality) {
+    for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+        resample_deinit(&stems->resampler[c]);
 
-    SDL_AudioSpec spec;
-    SDL_zero(spec);
-    spec.channels = 1;
-    spec.format = SDL_AUDIO_F32;
-    spec.freq = SAMPLE_RATE;
+        if (quality != AUDIO_QUALITY_DIRECT &&
+            resample_init(&stems->resampler[c], mix_rate(rate, quality), rate, AUDIO_ZERO_CROSSINGS[quality]) != CNES_SUCCESS) {
+            return CNES_FAILURE;
+        }
+
+        if (blip_init(&stems->blip[c], CPU_FREQ_NTSC, mix_rate(rate, quality)) != CNES_SUCCESS) {
+            return CNES_FAILURE;
+        }
+    }
+
+    return CNES_SUCCESS;
+}
 
-    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, "512");
+static void clear_stems(_apu_stems* stems) {
+    for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+        blip_clear(&stems->blip[c]);
+        resample_clear(&stems->resampler[c]);
+        stems->amplitude[c] = 0;
+    }
+}
+
+static void free_stems(_apu* apu) {
+    if (apu->stems) {
+        sink_close(&apu->stems->sink);
+        for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+            resample_deinit(&apu->stems->resampler[c]);
+        }
+        free(apu->stems);
+        apu->stems = NULL;
+    }
+}
 
-    apu->audio_stream = SDL_OpenAudioDeviceStream(
-        SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
-        &spec,
-        NULL,
-        NULL
-    );
+static uint32_t read_output(_apu* apu, _blip* blip, _resampler* resampler, int16_t* out, uint32_t max) {
+    if (apu->quality == AUDIO_QUALITY_DIRECT) {
+        return blip_read_samples(blip, out, max);
+    }
+
+    int16_t mixed[RESAMPLE_CHUNK];
+    uint32_t produced = 0;
+
+    // decimation never yields more samples than it takes, so a chunk always fits
+    while (max - produced >= RESAMPLE_CHUNK && blip_samples_avail(blip)) {
+        uint32_t count = blip_read_samples(blip, mixed, RESAMPLE_CHUNK);
+        produced += resample_run(resampler, mixed, count, out + produced, max - produced);
+    }
+
+    return produced;
+}
+
+// the stems share the mix timing and filters, so every one of them yields the same count
+static void drain_stems(_apu* apu) {
+    _apu_stems* stems = apu->stems;
+    if (!stems) return;
+
+    while (blip_samples_avail(&stems->blip[0])) {
+        uint32_t count = 0;
+
+        for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+            count = read_output(apu, &stems->blip[c], &stems->resampler[c], stems->samples, APU_MAX_FRAME_SAMPLES);
+
+            for (uint32_t i = 0; i < count; i++) {
+                stems->frames[i * AUDIO_STEMS + c] = stems->samples[i];
+            }
+        }
+
+        sink_write(&stems->sink, stems->frames, count * AUDIO_STEMS);
+    }
+}
+
+// a realtime sink only gets the frames that are meant to be heard, recordings get everything
+static void write_output(_apu* apu, uint8_t audible) {
+    if (audible || !apu->sink.queued) {
+        sink_write(&apu->sink, apu->sample_buffer, (uint32_t)apu->sample_count);
+    }
+
+    sink_write(&apu->recorder, apu->sample_buffer, (uint32_t)apu->sample_count);
+    apu->sample_count = 0;
+}
+
+static void end_audio_frame(_apu* apu) {
+    apu_sync(apu);
+
+    if (apu->audio_off) {
+        apu->blip_time = 0;
+        return;
+    }
+
+    blip_end_frame(&apu->blip, apu->blip_time);
+
+    if (apu->stems) {
+        for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+            blip_end_frame(&apu->stems->blip[c], apu->blip_time);
+        }
+    }
+
+    apu->blip_time = 0;
+
+    for (;;) {
+        int16_t* out = apu->sample_buffer + apu->sample_count;
+        apu->sample_count += read_output(apu, &apu->blip, &apu->resampler, out, APU_MAX_FRAME_SAMPLES - apu->sample_count);
+
+        // realtime sinks couldn't keep up with more anyway, the rest must not lose samples
+        if (!blip_samples_avail(&apu->blip) || (apu->sink.queued && !apu->recorder.active)) break;
+
+        write_output(apu, 0);
+    }
+
+    blip_read_samples(&apu->blip, NULL, blip_samples_avail(&apu->blip));
+}
+
+static uint32_t advance_timer(uint16_t* value, uint16_t period, uint32_t clocks) {
+    if (clocks <= *value) {
+        *value -= clocks;
+        return 0;
+    }
+
+    clocks -= *value + 1u;
+    *value = (uint16_t)(period - clocks % (period + 1u));
+    return 1 + clocks / (period + 1u);
+}
+
+static inline uint8_t pulse_audible(const _pulse* p) {
+    return p->length > 0 && p->timer >= 8 && !p->sweep_mute &&
+           (p->constant_volume ? p->volume_env : p->env) > 0;
+}
+
+static inline uint8_t noise_audible(const _noise* n) {
+    return n->length > 0 && (n->constant_volume ? n->volume_env : n->env) > 0;
+}
+
+static inline uint8_t triangle_stepping(const _triangle* t) {
+    return t->timer >= 2 && t->length > 0 && t->linear_counter > 0;
+}
+
+static uint32_t frame_counter_distance(const _apu* apu, int target) {
+    int f = apu->frame_cycle;
+    int period = apu->frame_counter.mode ? FC5_PERIOD : FC4_PERIOD;
+
+    if (f <= target) return (uint32_t)(target - f);
+    if (f <= period) return (uint32_t)(period - f + target);
+    return 0;
+}
+
+static uint32_t next_frame_counter_step(const _apu* apu) {
+    static const int steps4[] = { FC4_STEP1, FC4_STEP2, FC4_STEP3, FC4_STEP4, FC4_PERIOD };
+    static const int steps5[] = { 0, FC5_STEP1, FC5_STEP2, FC5_STEP3, FC5_STEP4, FC5_PERIOD };
+
+    const int* steps = apu->frame_counter.mode ? steps5 : steps4;
+    uint8_t count = apu->frame_counter.mode ? 6 : 5;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (apu->frame_cycle <= steps[i]) return (uint32_t)(steps[i] - apu->frame_cycle);
+    }
+    return 0;
+}
+
+static inline uint32_t half_clock_offset(const _apu* apu, uint32_t halves) {
+    return (apu->apu_divider ? 0 : 1) + 2 * halves;
+}
+
+// cycles until the next one that can change the output or the IRQ/DMA state;
+// with audio off only the latter matter
+static uint32_t next_event(const _apu* apu) {
+    uint32_t next = half_clock_offset(apu, next_frame_counter_step(apu));
+
+    if (apu->status.enable_dmc && apu->dmc.timer_value < next)
+        next = apu->dmc.timer_value;
+
+    if (apu->audio_off) return next;
+
+    if (triangle_stepping(&apu->triangle) && apu->triangle.timer_value < next)
+        next = apu->triangle.timer_value;
+    if (pulse_audible(&apu->pulse1) && half_clock_offset(apu, apu->pulse1.timer_value) < next)
+        next = half_clock_offset(apu, apu->pulse1.timer_value);
+    if (pulse_audible(&apu->pulse2) && half_clock_offset(apu, apu->pulse2.timer_value) < next)
+        next = half_clock_offset(apu, apu->pulse2.timer_value);
+    if (noise_audible(&apu->noise) && half_clock_offset(apu, apu->noise.timer_value) < next)
+        next = half_clock_offset(apu, apu->noise.timer_value);
+
+    return next;
+}
+
+static void skip_cycles(_apu* apu, uint32_t cycles) {
+    if (!cycles) return;
+
+    uint32_t halves = apu->apu_divider ? (cycles + 1) / 2 : cycles / 2;
+    apu->apu_divider ^= cycles & 1;
+    apu->blip_time += cycles;
+
+    if (apu->triangle.timer >= 2) {
+        uint8_t stepping = triangle_stepping(&apu->triangle);
+        uint32_t steps = advance_timer(&apu->triangle.timer_value, apu->triangle.timer, cycles);
+        if (stepping) apu->triangle.seq_step = (uint8_t)((apu->triangle.seq_step + steps) & 31);
+    }
+    if (apu->status.enable_dmc)
+        advance_timer(&apu->dmc.timer_value, apu->dmc.timer, cycles);
+
+    uint32_t steps = advance_timer(&apu->pulse1.timer_value, apu->pulse1.timer, halves);
+    apu->pulse1.step = (apu->pulse1.step - steps) & 7;
+    steps = advance_timer(&apu->pulse2.timer_value, apu->pulse2.timer, halves);
+    apu->pulse2.step = (apu->pulse2.step - steps) & 7;
+
+    steps = advance_timer(&apu->noise.timer_value, apu->noise.timer, halves);
+    while (steps--) noise_shift(&apu->noise);
+
+    apu->frame_cycle += (int)halves;
+}
+
+static void update_horizon(_apu* apu) {
+    uint32_t horizon = APU_MAX_HORIZON;
+
+    if (apu->status.enable_dmc && apu->dmc.timer_value + 1u < horizon)
+        horizon = apu->dmc.timer_value + 1u;
+
+    if (!apu->frame_counter.mode && !apu->frame_counter.irq_inhibit) {
+        uint32_t irq = half_clock_offset(apu, frame_counter_distance(apu, FC4_STEP4)) + 1;
+        if (irq < horizon) horizon = irq;
+    }
+
+    apu->horizon = horizon;
+}
+
+void apu_sync(_apu* apu) {
+    uint32_t cycles = apu->cycle_debt;
+    apu->cycle_debt = 0;
+
+    while (cycles) {
+        uint32_t skip = next_event(apu);
+        if (skip >= cycles) {
+            skip_cycles(apu, cycles);
+            break;
+        }
 
-    if (apu->audio_stream) {
-        SDL_ResumeAudioStreamDevice(apu->audio_stream);
+        skip_cycles(apu, skip);
+        apu_clock(apu);
+        cycles -= skip + 1;
     }
+
+    update_horizon(apu);
 }
 
 CNES_RESULT apu_init(_apu* apu) {
-    apu->audio_stream = NULL;
-    apu->audio_retry = 0;
+    apu->sink = sink_null();
+    apu->recorder = sink_null();
+    apu->stems = NULL;
+    apu->audio_off = 0;
     apu->sample_count = 0;
 
-    open_audio_stream(apu);
+    build_mix_tables();
 
-    if (!apu->audio_stream) {
-        fprintf(stderr, "[ERROR] Failed to open audio stream: %s\n", SDL_GetError());
+    if (apu_set_output(apu, SAMPLE_RATE, AUDIO_QUALITY_DIRECT) != CNES_SUCCESS) {
         return CNES_FAILURE;
     }
 
+    sink_open(&apu->sink, apu->sample_rate);
     return CNES_SUCCESS;
 }
 
+void apu_open_device(_apu* apu) {
+    // without an audio subsystem (headless) there is nothing to play back on
+    if (!SDL_WasInit(SDL_INIT_AUDIO)) return;
+
+    _sink device = sink_device();
+    if (apu_set_sink(apu, &device) != CNES_SUCCESS) {
+        fprintf(stderr, "[ERROR] Failed to open audio stream: %s, running without sound until it opens!\n", SDL_GetError());
+        sink_close(&apu->sink);
+        apu->sink = device;
+        sink_retry(&apu->sink, apu->sample_rate);
+    }
+}
+
 void apu_deinit(_apu* apu) {
-    if (apu->audio_stream) {
-        SDL_DestroyAudioStream(apu->audio_stream);
-        apu->audio_stream = NULL;
+    free_stems(apu);
+    sink_close(&apu->recorder);
+    sink_close(&apu->sink);
+    resample_deinit(&apu->resampler);
+}
+
+CNES_RESULT apu_set_sink(_apu* apu, const _sink* sink) {
+    _sink next = *sink;
+    if (sink_open(&next, apu->sample_rate) != CNES_SUCCESS) {
+        return CNES_FAILURE;
     }
+
+    sink_close(&apu->sink);
+    apu->sink = next;
+    apu->sample_count = 0;
+
+    return CNES_SUCCESS;
+}
+
+// written next to the main sink, so a recording doesn't take the speakers away
+CNES_RESULT apu_set_recorder(_apu* apu, const _sink* sink) {
+    _sink next = sink ? *sink : sink_null();
+    if (sink_open(&next, apu->sample_rate) != CNES_SUCCESS) {
+        return CNES_FAILURE;
+    }
+
+    sink_close(&apu->recorder);
+    apu->recorder = next;
+
+    return CNES_SUCCESS;
+}
+
+CNES_RESULT apu_set_stems(_apu* apu, const _sink* sink) {
+    if (!sink) {
+        free_stems(apu);
+        return CNES_SUCCESS;
+    }
+
+    _apu_stems* stems = (_apu_stems*)calloc(1, sizeof(_apu_stems));
+    if (!stems) return CNES_FAILURE;
+
+    stems->sink = *sink;
+    stems->sink.channels = AUDIO_STEMS;
+
+    if (init_stems(stems, apu->sample_rate, apu->quality) != CNES_SUCCESS ||
+        sink_open(&stems->sink, apu->sample_rate) != CNES_SUCCESS) {
+        for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+            resample_deinit(&stems->resampler[c]);
+        }
+        free(stems);
+        return CNES_FAILURE;
+    }
+
+    apu_sync(apu);
+    free_stems(apu);
+    apu->stems = stems;
+    update_output(apu);
+
+    return CNES_SUCCESS;
+}
+
+void apu_set_audio(_apu* apu, uint8_t enabled) {
+    if (apu->audio_off == !enabled) return;
+
+    apu_sync(apu);
+    apu->audio_off = !enabled;
+
+    blip_clear(&apu->blip);
+    resample_clear(&apu->resampler);
+    sink_clear(&apu->sink);
+    apu->sample_count = 0;
+    apu->amplitude = 0;
+
+    if (apu->stems) {
+        clear_stems(apu->stems);
+    }
+
+    update_output(apu);
+}
+
+CNES_RESULT apu_set_output(_apu* apu, uint32_t rate, _audio_quality quality) {
+    if (rate < APU_MIN_RATE || rate > APU_MAX_RATE || quality >= AUDIO_QUALITIES) {
+        fprintf(stderr, "[ERROR] Unsupported audio output %u Hz!\n", rate);
+        return CNES_FAILURE;
+    }
+
+    // reopening a file sink would truncate what has been recorded so far, so recordings pin the rate
+    if ((apu->recorder.active && apu->recorder.rate != rate) ||
+        (apu->stems && apu->stems->sink.rate != rate)) {
+        fprintf(stderr, "[ERROR] Can't change the audio rate to %u Hz while recording!\n", rate);
+        return CNES_FAILURE;
+    }
+
+    _resampler resampler;
+    memset(&resampler, 0, sizeof(_resampler));
+
+    if (quality != AUDIO_QUALITY_DIRECT &&
+        resample_init(&resampler, mix_rate(rate, quality), rate, AUDIO_ZERO_CROSSINGS[quality]) != CNES_SUCCESS) {
+        return CNES_FAILURE;
+    }
+
+    if (blip_init(&apu->blip, CPU_FREQ_NTSC, mix_rate(rate, quality)) != CNES_SUCCESS) {
+        resample_deinit(&resampler);
+        return CNES_FAILURE;
+    }
+
+    resample_deinit(&apu->resampler);
+    apu->resampler = resampler;
+    apu->sample_rate = rate;
+    apu->quality = (uint8_t)quality;
+    apu->sample_count = 0;
+
+    if ((apu->sink.active || apu->sink.retry) && apu->sink.rate != rate) {
+        sink_close(&apu->sink);
+        if (sink_open(&apu->sink, rate) != CNES_SUCCESS) {
+            fprintf(stderr, "[ERROR] Failed to reopen audio sink at %u Hz, running without sound until it opens!\n", rate);
+            sink_retry(&apu->sink, rate);
+        }
+    }
+
+    if (apu->stems && init_stems(apu->stems, rate, quality) != CNES_SUCCESS) {
+        fprintf(stderr, "[ERROR] Failed to rebuild audio stems, dropping them!\n");
+        free_stems(apu);
+    }
+
+    return CNES_SUCCESS;
 }
 
 void apu_reset(_apu* apu) {
     _apu saved = *apu;
     memset(apu, 0, sizeof(_apu));
 
-    apu->audio_stream = saved.audio_stream;
+    apu->sink = saved.sink;
+    apu->recorder = saved.recorder;
+    apu->stems = saved.stems;
+    apu->audio_off = saved.audio_off;
     apu->p_cpu = saved.p_cpu;
     apu->sample_count = 0;
 
-    if (apu->audio_stream) {
-        SDL_ClearAudioStream(apu->audio_stream);
+    apu->blip = saved.blip;
+    blip_clear(&apu->blip);
+
+    apu->sample_rate = saved.sample_rate;
+    apu->quality = saved.quality;
+    apu->resampler = saved.resampler;
+    resample_clear(&apu->resampler);
+
+    if (apu->stems) {
+        clear_stems(apu->stems);
     }
 
+    sink_clear(&apu->sink);
+
     apu->noise.shift_reg = 1;
     apu->noise.timer = noise_period[0];
     apu->noise.timer_value = apu->noise.timer;
@@ -114,89 +525,89 @@ void apu_reset(_apu* apu) {
     apu->dmc.bits_remaining = 8;
     apu->dmc.sample_buffer_empty = 1;
     apu->dmc.silence = 1;
-}
 
-void apu_flush_audio(_apu* apu) {
-    if (!apu->audio_stream) return;
-
-    if (apu->sample_count > 0) {
-        if (apu->audio_stream) {
-            SDL_PutAudioStreamData(
-                apu->audio_stream,
-                apu->sample_buffer,
-                apu->sample_count * sizeof(float)
-            );
-        } else {
-            if (apu->audio_retry-- == 0) {
-                open_audio_stream(apu);
-                apu->audio_retry = 120;
-            }
-        }
-        apu->sample_count = 0;
-    }
+    update_output(apu);
+    update_horizon(apu);
 }
 
-void apu_clock(_apu* apu) {
-    clock_triangle(&apu->triangle);
-    clock_dmc(apu);
+// steer the synthesis rate so the sink's queue settles at the target latency
+// queued is sampled before the frame is written, the low point the device has to ride out
+static void regulate_rate(_apu* apu, int queued) {
+    _audio_stats* stats = &apu->stats;
+    stats->underruns = sink_underruns(&apu->sink);
+
+    if (queued < 0 || apu->audio_off) {
+        stats->latency = 0.0;
+        stats->jitter = 0.0;
+        stats->ratio = 1.0;
+        apu->rate_integral = 0.0;
+    } else {
+        double latency = queued / (double)sizeof(int16_t) * 1000.0 / apu->sample_rate;
 
-    apu->apu_divider ^= 1;
-    if (apu->apu_divider == 0) {
-        clock_pulse(&apu->pulse1);
-        clock_pulse(&apu->pulse2);
-        clock_noise(&apu->noise);
-        clock_frame_counter(apu);
-    }
+        stats->latency += (latency - stats->latency) * APU_RATE_SMOOTHING;
+        stats->jitter += (fabs(latency - stats->latency) - stats->jitter) * APU_RATE_SMOOTHING;
 
-    const double s = SAMPLE_RATE / CPU_FREQ_NTSC;
-    apu->sample_acc += s;
+        double error = (stats->latency - APU_TARGET_LATENCY) / APU_TARGET_LATENCY;
+        apu->rate_integral += error * APU_RATE_INTEGRAL;
+        if (apu->rate_integral > 1.0) apu->rate_integral = 1.0;
+        if (apu->rate_integral < -1.0) apu->rate_integral = -1.0;
+
+        double control = error + apu->rate_integral;
+        if (control > 1.0) control = 1.0;
+        if (control < -1.0) control = -1.0;
+
+        stats->ratio = 1.0 - APU_RATE_DEVIATION * control;
+    }
 
-    if (apu->sample_acc >= 1.0) {
-        apu->sample_acc -= 1.0;
+    blip_set_ratio(&apu->blip, stats->ratio);
 
-        uint8_t raw_pulse1 = sample_pulse(&apu->pulse1);
-        uint8_t raw_pulse2 = sample_pulse(&apu->pulse2);
-        uint8_t raw_triangle = sample_triangle(&apu->triangle);
-        uint8_t raw_noise = sample_noise(&apu->noise);
-        uint8_t raw_dmc = sample_dmc(&apu->dmc);
+    if (apu->stems) {
+        for (uint8_t c = 0; c < AUDIO_STEMS; c++) {
+            blip_set_ratio(&apu->stems->blip[c], stats->ratio);
+        }
+    }
+}
 
-        int gate_pulse1 = apu->status.enable_pulse1 && apu->pulse1.length > 0 &&
-                          apu->pulse1.timer >= 8 && !apu->pulse1.sweep_mute &&
-                          ((apu->pulse1.constant_volume ? apu->pulse1.volume_env : apu->pulse1.env) > 0);
+void apu_flush_audio(_apu* apu) {
+    end_audio_frame(apu);
+    int queued = sink_queued(&apu->sink);
 
-        int gate_pulse2 = apu->status.enable_pulse2 && apu->pulse2.length > 0 &&
-                          apu->pulse2.timer >= 8 && !apu->pulse2.sweep_mute &&
-                          ((apu->pulse2.constant_volume ? apu->pulse2.volume_env : apu->pulse2.env) > 0);
+    write_output(apu, 1);
+    drain_stems(apu);
 
-        int gate_triangle = apu->status.enable_triangle && apu->triangle.length > 0 &&
-                            apu->triangle.linear_counter > 0 && apu->triangle.timer >= 2;
+    regulate_rate(apu, queued);
+}
 
-        int gate_noise = apu->status.enable_noise && apu->noise.length > 0 &&
-                         ((apu->noise.constant_volume ? apu->noise.volume_env : apu->noise.env) > 0);
+void apu_discard_audio(_apu* apu) {
+    end_audio_frame(apu);
 
-        apu->pulse1_gain = ramp_gain(apu->pulse1_gain, gate_pulse1, &apu->pulse1_ramp);
-        apu->pulse2_gain = ramp_gain(apu->pulse2_gain, gate_pulse2, &apu->pulse2_ramp);
-        apu->triangle_gain = ramp_gain(apu->triangle_gain, gate_triangle, &apu->triangle_ramp);
-        apu->noise_gain = ramp_gain(apu->noise_gain, gate_noise, &apu->noise_ramp);
+    write_output(apu, 0);
+    drain_stems(apu);
+}
 
-        float s_pulse1 = raw_pulse1 * apu->pulse1_gain;
-        float s_pulse2 = raw_pulse2 * apu->pulse2_gain;
-        float s_triangle = raw_triangle * apu->triangle_gain;
-        float s_noise = raw_noise * apu->noise_gain;
-        float s_dmc = (float)raw_dmc;
+void apu_clock(_apu* apu) {
+    uint8_t changed = clock_triangle(&apu->triangle) | clock_dmc(apu);
 
-        float sample = mix(s_pulse1, s_pulse2, s_triangle, s_noise, s_dmc);
-        sample = dc_block(apu, sample);
+    apu->apu_divider ^= 1;
+    if (apu->apu_divider == 0) {
+        changed |= clock_pulse(&apu->pulse1);
+        changed |= clock_pulse(&apu->pulse2);
+        changed |= clock_noise(&apu->noise);
+        changed |= clock_frame_counter(apu);
+    }
 
-        if (apu->sample_count < APU_MAX_FRAME_SAMPLES) {
-            apu->sample_buffer[apu->sample_count++] = sample;
-        }
+    if (changed) {
+        update_output(apu);
     }
+
+    apu->blip_time++;
 }
 
 uint8_t apu_cpu_read(_apu* apu, uint16_t addr) {
     if (addr != 0x4015) return 0x00;
 
+    apu_sync(apu);
+
     uint8_t data = 0;
     if (apu->pulse1.length > 0) data |= 0x01;
     if (apu->pulse2.length > 0) data |= 0x02;
@@ -213,6 +624,8 @@ uint8_t apu_cpu_read(_apu* apu, uint16_t addr) {
 }
 
 void apu_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
+    apu_sync(apu);
+
     if (0x4000 <= addr && addr <= 0x4003) {
         pulse1_cpu_write(apu, addr, data);
     } else if (0x4004 <= addr && addr <= 0x4007) {
@@ -275,6 +688,9 @@ void apu_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
             clock_pulse_sweep(&apu->pulse2, 0);
         }
     }
+
+    update_output(apu);
+    update_horizon(apu);
 }
 
 void pulse1_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
@@ -302,7 +718,8 @@ void pulse1_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
             apu->pulse1.length_counter_load = (data & 0xF8) >> 3;
             apu->pulse1.step = 0;
             apu->pulse1.env_start = 1;
-            apu->pulse1.length = length_table[apu->pulse1.length_counter_load];
+            if (apu->status.enable_pulse1)
+                apu->pulse1.length = length_table[apu->pulse1.length_counter_load];
             break;
         default: break;
     }
@@ -333,7 +750,8 @@ void pulse2_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
             apu->pulse2.length_counter_load = (data & 0xF8) >> 3;
             apu->pulse2.step = 0;
             apu->pulse2.env_start = 1;
-            apu->pulse2.length = length_table[apu->pulse2.length_counter_load];
+            if (apu->status.enable_pulse2)
+                apu->pulse2.length = length_table[apu->pulse2.length_counter_load];
             break;
         default: break;
     }
@@ -354,7 +772,8 @@ void triangle_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
             apu->triangle.timer |= (uint16_t)(data & 0x07) << 8;
             apu->triangle.length_counter_load = (data & 0xF8) >> 3;
             apu->triangle.linear_reload = 1;
-            apu->triangle.length = length_table[apu->triangle.length_counter_load];
+            if (apu->status.enable_triangle)
+                apu->triangle.length = length_table[apu->triangle.length_counter_load];
             break;
         default: break;
     }
@@ -375,7 +794,8 @@ void noise_cpu_write(_apu* apu, uint16_t addr, uint8_t data) {
         case 0x400F:
             apu->noise.length_counter_load = (data & 0xF8) >> 3;
             apu->noise.env_start = 1;
-            apu->noise.length = length_table[apu->noise.length_counter_load];
+            if (apu->status.enable_noise)
+                apu->noise.length = length_table[apu->noise.length_counter_load];
             apu->noise.timer_value = apu->noise.timer;
             break;
         default: break;
@@ -425,13 +845,15 @@ static inline void clock_half_frame(_apu* apu) {
     clock_pulse_sweep(&apu->pulse2, 0);
 }
 
-void clock_frame_counter(_apu* apu) {
+uint8_t clock_frame_counter(_apu* apu) {
     int c = apu->frame_cycle++;
+    uint8_t clocked = 0;
 
     if (apu->frame_counter.mode == 0) {
         if (c == FC4_STEP1 || c == FC4_STEP2 ||
             c == FC4_STEP3 || c == FC4_STEP4) {
             clock_quarter_frame(apu);
+            clocked = 1;
         }
         if (c == FC4_STEP2 || c == FC4_STEP4) {
             clock_half_frame(apu);
@@ -446,6 +868,7 @@ void clock_frame_counter(_apu* apu) {
         if (c == 0 || c == FC5_STEP1 || c == FC5_STEP2 ||
             c == FC5_STEP3 || c == FC5_STEP4) {
             clock_quarter_frame(apu);
+            clocked = 1;
         }
         if (c == FC5_STEP2 || c == FC5_STEP4) {
             clock_half_frame(apu);
@@ -454,6 +877,8 @@ void clock_frame_counter(_apu* apu) {
             apu->frame_cycle -= FC5_PERIOD;
         }
     }
+
+    return clocked;
 }
 
 void clock_pulse_envelope(_pulse* p) {
@@ -514,13 +939,15 @@ void clock_pulse_sweep(_pulse* p, int is_pulse1) {
     }
 }
 
-void clock_pulse(_pulse* p) {
+uint8_t clock_pulse(_pulse* p) {
     if (p->timer_value == 0) {
         p->timer_value = p->timer;
         p->step = (p->step - 1) & 7;
-    } else {
-        p->timer_value--;
+        return 1;
     }
+
+    p->timer_value--;
+    return 0;
 }
 
 uint8_t sample_pulse(_pulse* p) {
@@ -551,16 +978,18 @@ void clock_triangle_length(_triangle* t) {
     }
 }
 
-void clock_triangle(_triangle* t) {
-    if (t->timer < 2) return;
+uint8_t clock_triangle(_triangle* t) {
+    if (t->timer < 2) return 0;
     if (t->timer_value == 0) {
         t->timer_value = t->timer;
         if (t->length > 0 && t->linear_counter > 0) {
             t->seq_step = (t->seq_step + 1) & 31;
+            return 1;
         }
     } else {
         t->timer_value--;
     }
+    return 0;
 }
 
 uint8_t sample_triangle(_triangle* t) {
@@ -592,24 +1021,15 @@ void clock_noise_length(_noise* n) {
     }
 }
 
-void clock_noise(_noise* n) {
+uint8_t clock_noise(_noise* n) {
     if (n->timer_value == 0) {
         n->timer_value = n->timer;
-        uint16_t feedback;
-        if (n->mode) {
-            feedback = ((n->shift_reg & 0x0001) ^ ((n->shift_reg & 0x0040) >> 6));
-        } else {
-            feedback = ((n->shift_reg & 0x0001) ^ ((n->shift_reg & 0x0002) >> 1));
-        }
-        n->shift_reg >>= 1;
-        if (feedback) {
-            n->shift_reg |= 0x4000;
-        } else {
-            n->shift_reg &= ~0x4000;
-        }
-    } else {
-        n->timer_value--;
+        noise_shift(n);
+        return 1;
     }
+
+    n->timer_value--;
+    return 0;
 }
 
 uint8_t sample_noise(_noise* n) {
@@ -655,9 +1075,9 @@ void dmc_dma_complete(_apu* apu) {
     }
 }
 
-void clock_dmc(_apu* apu) {
+uint8_t clock_dmc(_apu* apu) {
     _dmc* d = &apu->dmc;
-    if (!apu->status.enable_dmc) return;
+    if (!apu->status.enable_dmc) return 0;
     if (d->timer_value == 0) {
         d->timer_value = d->timer;
         if (!d->silence) {
@@ -680,9 +1100,11 @@ void clock_dmc(_apu* apu) {
             }
         }
         dmc_fill_sample_buffer(apu);
-    } else {
-        d->timer_value--;
+        return 1;
     }
+
+    d->timer_value--;
+    return 0;
 }
 
 uint8_t sample_dmc(_dmc* d) {
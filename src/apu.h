@@ -1,12 +1,22 @@
 #pragma once
+#include "blip.h"
 #include "cnes.h"
-#include <SDL3/SDL_audio.h>
-#include <SDL3/SDL_hints.h>
-
-#define CPU_FREQ_NTSC 1789773.0
-#define SAMPLE_RATE 48000.0
-#define APU_MAX_FRAME_SAMPLES 2048
-#define RAMP_SAMPLES 64
+#include "resample.h"
+#include "sink.h"
+
+#define CPU_FREQ_NTSC 1789773
+#define APU_OUTPUT_ONE 32768
+#define SAMPLE_RATE 48000
+#define APU_MIN_RATE 22050
+#define APU_MAX_RATE 192000
+#define APU_DECIMATION 8
+#define APU_MAX_FRAME_SAMPLES 4096
+#define APU_MAX_HORIZON 0x10000
+
+#define APU_TARGET_LATENCY 32.0
+#define APU_RATE_DEVIATION 0.005
+#define APU_RATE_SMOOTHING 0.05
+#define APU_RATE_INTEGRAL  0.005
 
 #define FC4_STEP1  3728
 #define FC4_STEP2  7456
@@ -21,6 +31,43 @@
 #define FC5_STEP5   18640
 #define FC5_PERIOD  18641
 
+typedef enum _audio_quality {
+    AUDIO_QUALITY_DIRECT,
+    AUDIO_QUALITY_LOW,
+    AUDIO_QUALITY_MEDIUM,
+    AUDIO_QUALITY_HIGH,
+    AUDIO_QUALITIES
+} _audio_quality;
+
+static const char* const AUDIO_QUALITY_NAMES[AUDIO_QUALITIES] = { "DIRECT", "LOW", "MEDIUM", "HIGH" };
+static const uint8_t AUDIO_ZERO_CROSSINGS[AUDIO_QUALITIES] = { 0, 4, 8, 16 };
+
+typedef enum _audio_stem {
+    AUDIO_STEM_PULSE1,
+    AUDIO_STEM_PULSE2,
+    AUDIO_STEM_TRIANGLE,
+    AUDIO_STEM_NOISE,
+    AUDIO_STEM_DMC,
+    AUDIO_STEMS
+} _audio_stem;
+
+// every channel run through its own copy of the mix pipeline, written as interleaved frames
+typedef struct _apu_stems {
+    _blip blip[AUDIO_STEMS];
+    _resampler resampler[AUDIO_STEMS];
+    int32_t amplitude[AUDIO_STEMS];
+    int16_t samples[APU_MAX_FRAME_SAMPLES];
+    int16_t frames[APU_MAX_FRAME_SAMPLES * AUDIO_STEMS];
+    _sink sink;
+} _apu_stems;
+
+typedef struct _audio_stats {
+    double latency;
+    double jitter;
+    double ratio;
+    uint32_t underruns;
+} _audio_stats;
+
 typedef struct _pulse {
     uint8_t duty;
     uint8_t env_loop;
@@ -123,11 +170,15 @@ typedef struct _frame_counter {
 typedef struct _cpu _cpu;
 
 typedef struct _apu {
-    SDL_AudioStream* audio_stream;
-    uint8_t audio_retry;
+    _sink sink;
+    _sink recorder;
+    _apu_stems* stems;
+    uint8_t audio_off;
+    _audio_stats stats;
+    double rate_integral;
     _cpu* p_cpu;
 
-    float sample_buffer[APU_MAX_FRAME_SAMPLES];
+    int16_t sample_buffer[APU_MAX_FRAME_SAMPLES];
     int sample_count;
 
     _pulse pulse1;
@@ -141,21 +192,33 @@ typedef struct _apu {
     uint8_t frame_counter_irq;
 
     uint8_t apu_divider;
-    double sample_acc;
     int frame_cycle;
 
-    float dc_prev_in;
-    float dc_prev_out;
+    uint32_t cycle_debt;
+    uint32_t horizon;
+
+    _blip blip;
+    uint32_t blip_time;
+    int32_t amplitude;
 
-    float pulse1_gain, pulse2_gain, triangle_gain, noise_gain, dmc_gain;
-    int pulse1_ramp, pulse2_ramp, triangle_ramp, noise_ramp, dmc_ramp;
+    uint32_t sample_rate;
+    uint8_t quality;
+    _resampler resampler;
 } _apu;
 
 CNES_RESULT apu_init(_apu* apu);
+void apu_open_device(_apu* apu);
 void apu_deinit(_apu* apu);
 void apu_reset(_apu* apu);
+CNES_RESULT apu_set_output(_apu* apu, uint32_t rate, _audio_quality quality);
+CNES_RESULT apu_set_sink(_apu* apu, const _sink* sink);
+CNES_RESULT apu_set_recorder(_apu* apu, const _sink* sink);
+CNES_RESULT apu_set_stems(_apu* apu, const _sink* sink);
+void apu_set_audio(_apu* apu, uint8_t enabled);
 void apu_clock(_apu* apu);
+void apu_sync(_apu* apu);
 void apu_flush_audio(_apu* apu);
+void apu_discard_audio(_apu* apu);
 
 uint8_t apu_cpu_read(_apu* apu, uint16_t addr);
 void apu_cpu_write(_apu* apu, uint16_t addr, uint8_t data);
@@ -170,19 +233,19 @@ void dmc_dma_complete(_apu* apu);
 void clock_pulse_envelope(_pulse* p);
 void clock_pulse_length(_pulse* p);
 void clock_pulse_sweep(_pulse* p, int is_pulse1);
-void clock_pulse(_pulse* p);
+uint8_t clock_pulse(_pulse* p);
 uint8_t sample_pulse(_pulse* p);
 
 void clock_triangle_linear(_triangle* t);
 void clock_triangle_length(_triangle* t);
-void clock_triangle(_triangle* t);
+uint8_t clock_triangle(_triangle* t);
 uint8_t sample_triangle(_triangle* t);
 
 void clock_noise_envelope(_noise* n);
 void clock_noise_length(_noise* n);
-void clock_noise(_noise* n);
+uint8_t clock_noise(_noise* n);
 uint8_t sample_noise(_noise* n);
 
-void clock_dmc(_apu* apu);
+uint8_t clock_dmc(_apu* apu);
 uint8_t sample_dmc(_dmc* d);
-void clock_frame_counter(_apu* apu);
+uint8_t clock_frame_counter(_apu* apu);
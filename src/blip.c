@@ -0,0 +1,142 @@
+#include "blip.h"
+#include "cnes.h"
+#include "fixed.h"
+#include "simd.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BLIP_CUTOFF     1932735283u
+#define BLIP_BLACKMAN0  450971566
+#define BLIP_BLACKMAN1  536870912
+#define BLIP_BLACKMAN2  85899346
+
+static void build_kernel(_blip* blip) {
+    for (uint8_t p = 0; p < BLIP_PHASES; p++) {
+        int32_t taps[BLIP_TAPS];
+
+        for (uint8_t i = 0; i < BLIP_TAPS; i++) {
+            int32_t t = (i - BLIP_HALF) * 65536 - p * (65536 / BLIP_PHASES);
+
+            if (t <= -BLIP_HALF * 65536) {
+                taps[i] = 0;
+                continue;
+            }
+
+            int64_t window = BLIP_BLACKMAN0 +
+                (((int64_t)BLIP_BLACKMAN1 * fixed_cos((uint32_t)t << 12)) >> FIXED_BITS) +
+                (((int64_t)BLIP_BLACKMAN2 * fixed_cos((uint32_t)t << 13)) >> FIXED_BITS);
+
+            taps[i] = (int32_t)((fixed_sinc(BLIP_CUTOFF, t) * window) >> FIXED_BITS);
+        }
+
+        fixed_normalize(taps, blip->kernel[p], BLIP_TAPS, BLIP_KERNEL_BITS);
+    }
+}
+
+CNES_RESULT blip_init(_blip* blip, uint32_t clock_rate, uint32_t sample_rate) {
+    if (!clock_rate || !sample_rate || sample_rate >= clock_rate) {
+        fprintf(stderr, "[ERROR] Invalid band-limited buffer rates!\n");
+        return CNES_FAILURE;
+    }
+
+    build_kernel(blip);
+    blip->base_factor = (((uint64_t)sample_rate << BLIP_FRAC_BITS) + clock_rate - 1) / clock_rate;
+    blip->factor = blip->base_factor;
+
+    // the leak 2^-shift closest to a BLIP_HIGHPASS / rate pole, rounded in the log domain
+    blip->bass_shift = 0;
+    while (((uint64_t)BLIP_HIGHPASS << (blip->bass_shift + 1)) * 128 <= (uint64_t)sample_rate * 181) {
+        blip->bass_shift++;
+    }
+
+    blip_clear(blip);
+
+    return CNES_SUCCESS;
+}
+
+void blip_clear(_blip* blip) {
+    memset(blip->buffer, 0, sizeof(blip->buffer));
+    blip->offset = 0;
+    blip->integrator = 0;
+}
+
+// only call between frames, the pending deltas are positioned with the old factor
+void blip_set_ratio(_blip* blip, double ratio) {
+    blip->factor = (uint64_t)((double)blip->base_factor * ratio);
+}
+
+void blip_add_delta(_blip* blip, uint32_t time, int32_t delta) {
+    uint64_t fixed = blip->offset + time * blip->factor;
+    uint64_t pos = fixed >> BLIP_FRAC_BITS;
+    if (pos >= BLIP_CAPACITY) return;
+
+    // the vector paths multiply in 16 bits, split the rare full-scale step
+    if (delta > INT16_MAX || delta < -INT16_MAX) {
+        blip_add_delta(blip, time, delta / 2);
+        delta -= delta / 2;
+    }
+
+    const int16_t* kernel = blip->kernel[(fixed >> (BLIP_FRAC_BITS - BLIP_PHASE_BITS)) & (BLIP_PHASES - 1)];
+    int32_t* out = &blip->buffer[pos];
+
+#if defined(CNES_SSE2)
+    __m128i d = _mm_set1_epi16((int16_t)delta);
+
+    for (uint8_t i = 0; i < BLIP_TAPS; i += 8) {
+        __m128i k = _mm_loadu_si128((const __m128i*)(kernel + i));
+        __m128i lo = _mm_mullo_epi16(k, d);
+        __m128i hi = _mm_mulhi_epi16(k, d);
+        __m128i* o = (__m128i*)(out + i);
+
+        _mm_storeu_si128(o, _mm_add_epi32(_mm_loadu_si128(o), _mm_unpacklo_epi16(lo, hi)));
+        _mm_storeu_si128(o + 1, _mm_add_epi32(_mm_loadu_si128(o + 1), _mm_unpackhi_epi16(lo, hi)));
+    }
+#elif defined(CNES_NEON)
+    for (uint8_t i = 0; i < BLIP_TAPS; i += 4) {
+        vst1q_s32(out + i, vmlal_n_s16(vld1q_s32(out + i), vld1_s16(kernel + i), (int16_t)delta));
+    }
+#else
+    for (uint8_t i = 0; i < BLIP_TAPS; i++) {
+        out[i] += delta * kernel[i];
+    }
+#endif
+}
+
+void blip_end_frame(_blip* blip, uint32_t time) {
+    blip->offset += time * blip->factor;
+
+    if ((blip->offset >> BLIP_FRAC_BITS) > BLIP_CAPACITY) {
+        blip->offset = (uint64_t)BLIP_CAPACITY << BLIP_FRAC_BITS;
+    }
+}
+
+uint32_t blip_samples_avail(const _blip* blip) {
+    return (uint32_t)(blip->offset >> BLIP_FRAC_BITS);
+}
+
+uint32_t blip_read_samples(_blip* blip, int16_t* out, uint32_t count) {
+    uint32_t avail = blip_samples_avail(blip);
+    if (count > avail) count = avail;
+
+    int32_t sum = blip->integrator;
+    uint8_t shift = blip->bass_shift;
+
+    for (uint32_t i = 0; i < count; i++) {
+        sum += blip->buffer[i];
+
+        if (out) {
+            int32_t s = sum >> BLIP_KERNEL_BITS;
+            out[i] = (int16_t)(s > INT16_MAX ? INT16_MAX : s < INT16_MIN ? INT16_MIN : s);
+        }
+
+        sum -= sum >> shift;
+    }
+    blip->integrator = sum;
+
+    uint32_t remain = avail - count + BLIP_TAPS;
+    memmove(blip->buffer, blip->buffer + count, remain * sizeof(int32_t));
+    memset(blip->buffer + remain, 0, count * sizeof(int32_t));
+
+    blip->offset -= (uint64_t)count << BLIP_FRAC_BITS;
+    return count;
+}
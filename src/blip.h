@@ -0,0 +1,31 @@
+#pragma once
+#include "cnes.h"
+#include <stdint.h>
+
+#define BLIP_CAPACITY   8192
+#define BLIP_FRAC_BITS  32
+#define BLIP_PHASE_BITS 6
+#define BLIP_PHASES     (1 << BLIP_PHASE_BITS)
+#define BLIP_TAPS       16
+#define BLIP_HALF       (BLIP_TAPS / 2)
+#define BLIP_KERNEL_BITS 12
+#define BLIP_HIGHPASS   239 // 2 * pi * 38 Hz
+
+typedef struct _blip {
+    int16_t kernel[BLIP_PHASES][BLIP_TAPS];
+    int32_t buffer[BLIP_CAPACITY + BLIP_TAPS];
+
+    uint64_t factor;
+    uint64_t base_factor;
+    uint64_t offset;
+    int32_t integrator;
+    uint8_t bass_shift;
+} _blip;
+
+CNES_RESULT blip_init(_blip* blip, uint32_t clock_rate, uint32_t sample_rate);
+void blip_clear(_blip* blip);
+void blip_set_ratio(_blip* blip, double ratio);
+void blip_add_delta(_blip* blip, uint32_t time, int32_t delta);
+void blip_end_frame(_blip* blip, uint32_t time);
+uint32_t blip_samples_avail(const _blip* blip);
+uint32_t blip_read_samples(_blip* blip, int16_t* out, uint32_t count);
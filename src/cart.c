@@ -29,8 +29,17 @@ CNES_RESULT cart_load(_cart* cart) {
     cart->alt_ntbl_layout = header[6] & 0x08;
     cart->mapper_id = (header[6] >> 4) | (header[7] & 0xF0);
 
-    if (cart->alt_ntbl_layout) cart->mirror = MIRROR_FOUR;
-    else cart->mirror = cart->ntbl_layout ? MIRROR_VERTICAL : MIRROR_HORIZONTAL;
+    if (cart->alt_ntbl_layout) {
+        cart->vram = (_mem){
+            .data = calloc(1, 0x800),
+            .size = 0x800,
+            .writeable = 1
+        };
+
+        cart_set_mirror(cart, MIRROR_FOUR);
+    } else {
+        cart_set_mirror(cart, cart->ntbl_layout ? MIRROR_VERTICAL : MIRROR_HORIZONTAL);
+    }
 
     uint8_t nes2 = (header[7] & 0x0C) == 0x08;
     if (nes2) parse_nes2(cart, header);
@@ -155,6 +164,11 @@ void cart_unload(_cart* cart) {
         memset(&cart->chr_nvram, 0, sizeof(_mem));
     }
 
+    if (cart->vram.data) {
+        free(cart->vram.data);
+        memset(&cart->vram, 0, sizeof(_mem));
+    }
+
     if (cart->mapper.deinit) {
         cart->mapper.deinit(cart);
     }
@@ -180,6 +194,38 @@ void parse_nes2(_cart* cart, uint8_t header[16]) {
     cart->expansion_device = header[15] & 0x3F;
 }
 
+void cart_set_mirror(_cart* cart, _mirror mirror) {
+    if (cart->alt_ntbl_layout) mirror = MIRROR_FOUR;
+    cart->mirror = mirror;
+
+    uint8_t* nt0 = cart->ciram;
+    uint8_t* nt1 = cart->ciram + 0x400;
+
+    switch (mirror) {
+        case MIRROR_HORIZONTAL:
+            cart->ntbl[0] = nt0; cart->ntbl[1] = nt0;
+            cart->ntbl[2] = nt1; cart->ntbl[3] = nt1;
+            break;
+        case MIRROR_VERTICAL:
+            cart->ntbl[0] = nt0; cart->ntbl[1] = nt1;
+            cart->ntbl[2] = nt0; cart->ntbl[3] = nt1;
+            break;
+        case MIRROR_SINGLE0:
+            cart->ntbl[0] = nt0; cart->ntbl[1] = nt0;
+            cart->ntbl[2] = nt0; cart->ntbl[3] = nt0;
+            break;
+        case MIRROR_SINGLE1:
+            cart->ntbl[0] = nt1; cart->ntbl[1] = nt1;
+            cart->ntbl[2] = nt1; cart->ntbl[3] = nt1;
+            break;
+        case MIRROR_FOUR:
+            cart->ntbl[0] = nt0; cart->ntbl[1] = nt1;
+            cart->ntbl[2] = cart->vram.data;
+            cart->ntbl[3] = cart->vram.data + 0x400;
+            break;
+    }
+}
+
 uint8_t cart_cpu_read(_cart* cart, uint16_t addr) {
     return cart->mapper.cpu_read(cart, addr);
 }
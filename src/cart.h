@@ -9,6 +9,7 @@ typedef struct _cpu _cpu;
 typedef CNES_RESULT (*map_fn_ctrl)(_cart*);
 typedef uint8_t (*map_fn_read)(_cart*, uint16_t);
 typedef void (*map_fn_write)(_cart*, uint16_t, uint8_t);
+typedef void (*map_fn_a12)(_cart*);
 
 typedef enum {
     MIRROR_HORIZONTAL = 0,
@@ -26,6 +27,7 @@ typedef struct _mapper {
     map_fn_write cpu_write;
     map_fn_read ppu_read;
     map_fn_write ppu_write;
+    map_fn_a12 a12_rise;
     void* data;
 } _mapper;
 
@@ -47,9 +49,17 @@ typedef struct _cart {
     _mem chr_ram;
     _mem chr_nvram;
 
+    _mem vram;
+
     _mapper mapper;
     _mirror mirror;
 
+    uint8_t* ciram;
+    uint8_t* ntbl[4];
+
+    uint32_t chr_gen;
+    uint8_t ppu_snoop;
+
     uint16_t prg_rom_banks;
     uint16_t chr_rom_banks;
     uint16_t mapper_id;
@@ -75,6 +85,7 @@ CNES_RESULT cart_load(_cart* cart);
 void cart_unload(_cart* cart);
 void parse_ines(_cart* cart, uint8_t header[16]);
 void parse_nes2(_cart* cart, uint8_t header[16]);
+void cart_set_mirror(_cart* cart, _mirror mirror);
 
 uint8_t cart_cpu_read(_cart* cart, uint16_t addr);
 void cart_cpu_write(_cart* cart, uint16_t addr, uint8_t data);
@@ -3,6 +3,7 @@
 #include "cart.h"
 #include "input.h"
 #include "ppu.h"
+#include "reglog.h"
 #include <ctype.h>
 #include <string.h>
 #include <stdio.h>
@@ -52,6 +53,7 @@ void cpu_clock(_cpu* cpu) {
         cpu->irq_state = IRQ_NORMAL;
     }
 
+    cpu->instr_pc = cpu->pc;
     uint8_t opcode = cpu_read(cpu, cpu->pc++);
     cpu->opcode = opcode;
     cpu->instr = instructions[opcode];
@@ -121,6 +123,8 @@ void cpu_nmi(_cpu* cpu) {
 uint8_t cpu_read(_cpu* cpu, uint16_t addr) {
     uint8_t data = cpu->open_bus;
 
+    if (0x2000 <= addr && addr <= 0x5FFF) cpu->io_access = 1;
+
     if (0x0000 <= addr && addr <= 0x1FFF) {
         data = cpu->ram[addr & 0x07FF];
     } else if (0x2000 <= addr && addr <= 0x3FFF) {
@@ -143,6 +147,11 @@ uint8_t cpu_read(_cpu* cpu, uint16_t addr) {
 void cpu_write(_cpu* cpu, uint16_t addr, uint8_t data) {
     cpu->open_bus = data;
 
+    if (addr >= 0x2000 && (addr < 0x6000 || addr > 0x7FFF)) {
+        cpu->io_access = 1;
+        if (cpu->p_log) reglog_record(cpu->p_log, cpu->p_ppu, cpu->instr_pc, addr, data);
+    }
+
     if (0x0000 <= addr && addr <= 0x1FFF) {
         cpu->ram[addr & 0x07FF] = data;
     } else if (0x2000 <= addr && addr <= 0x3FFF) {
@@ -155,6 +164,9 @@ void cpu_write(_cpu* cpu, uint16_t addr, uint8_t data) {
         input_cpu_write(cpu->p_input, addr, data);
     } else if (0x4020 <= addr && addr <= 0xFFFF) {
         if (cpu->p_cart) {
+            if (addr < 0x6000 || addr > 0x7FFF) {
+                ppu_bgrnd_memo_break(cpu->p_ppu);
+            }
             cart_cpu_write(cpu->p_cart, addr, data);
         }
     }
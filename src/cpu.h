@@ -15,6 +15,7 @@ typedef struct _apu _apu;
 typedef struct _ppu _ppu;
 typedef struct _cart _cart;
 typedef struct _input _input;
+typedef struct _reglog _reglog;
 
 typedef struct _instr {
     uint8_t opcode[4];          // name of opcode
@@ -39,6 +40,7 @@ typedef struct _cpu {
     uint8_t p;              // status flags
     uint8_t s;              // stack pointer
     uint16_t pc;            // program counter
+    uint16_t instr_pc;      // address of active instruction
 
     _instr instr;           // active instruction
     uint8_t opcode;
@@ -57,11 +59,13 @@ typedef struct _cpu {
     _irq_state irq_state;
     uint8_t irq_pending;
     uint8_t nmi_pending;
+    uint8_t io_access;      // touched a register that can reschedule events
 
     _apu* p_apu;
     _ppu* p_ppu;            // ref for ppu regs cpu-side
     _cart* p_cart;          // ref for cart mapper cpu-side
     _input* p_input;        // ref for controller input
+    _reglog* p_log;         // register write log, NULL when disabled
 } _cpu;
 
 typedef enum _cpu_flag {
@@ -0,0 +1,92 @@
+#include "fixed.h"
+
+#define FIXED_TWO_PI 6588397
+#define FIXED_I0_BITS 20
+
+// (-1)^k * (pi/2)^(2k+1) / (2k+1)!, Q30
+static const int64_t SIN_TERMS[7] = { 1686629713, -693598668, 85569306, -5026995, 172272, -3864, 61 };
+
+// sin(2 * pi * turn / 2^32), Q30
+int32_t fixed_sin(uint32_t turn) {
+    int64_t z = (int32_t)turn;
+
+    if (z > FIXED_ONE) z = 2 * (int64_t)FIXED_ONE - z;
+    if (z < -FIXED_ONE) z = -2 * (int64_t)FIXED_ONE - z;
+
+    int64_t z2 = (z * z) >> FIXED_BITS;
+    int64_t r = SIN_TERMS[6];
+
+    for (int8_t k = 5; k >= 0; k--) {
+        r = SIN_TERMS[k] + ((r * z2) >> FIXED_BITS);
+    }
+
+    return (int32_t)((r * z) >> FIXED_BITS);
+}
+
+int32_t fixed_cos(uint32_t turn) {
+    return fixed_sin(turn + (1u << 30));
+}
+
+// sin(2 pi c t) / (2 pi c t) for a Q32 cutoff c (cycles per sample) and a Q16 time t, Q30
+int32_t fixed_sinc(uint32_t cutoff, int32_t t) {
+    int64_t ct = ((int64_t)cutoff * t) >> 16;
+    if (ct == 0) return FIXED_ONE;
+
+    int64_t s = fixed_sin((uint32_t)ct);
+    int64_t angle = (ct * FIXED_TWO_PI) >> 20;
+
+    return (int32_t)(s * (1ll << 32) / angle);
+}
+
+// modified Bessel function of the first kind for a Q16 argument, Q20
+int64_t fixed_bessel_i0(uint32_t x) {
+    int64_t y = ((int64_t)x * x) >> 10;
+    int64_t term = 1 << FIXED_I0_BITS;
+    int64_t sum = term;
+
+    for (int64_t k = 1; k < 48 && term; k++) {
+        term = ((term * y) >> 24) / (k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+uint32_t fixed_sqrt(uint64_t x) {
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > x) bit >>= 2;
+
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+// scale taps to sum to exactly 1 << bits, folding the rounding residue into the largest tap
+void fixed_normalize(const int32_t* taps, int16_t* out, uint16_t count, uint8_t bits) {
+    int64_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) sum += taps[i];
+
+    int64_t total = 0;
+    uint16_t peak = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        int64_t scaled = (int64_t)taps[i] * (1ll << bits);
+        scaled = scaled >= 0 ? (scaled + sum / 2) / sum : (scaled - sum / 2) / sum;
+
+        out[i] = (int16_t)scaled;
+        total += scaled;
+        if (taps[i] > taps[peak]) peak = i;
+    }
+
+    out[peak] = (int16_t)(out[peak] + ((1 << bits) - total));
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+
+// integer-only helpers for building filter kernels, so the tables come out
+// bit-identical on every compiler, libm and architecture
+
+#define FIXED_BITS 30
+#define FIXED_ONE  (1 << FIXED_BITS)
+
+int32_t fixed_sin(uint32_t turn);
+int32_t fixed_cos(uint32_t turn);
+int32_t fixed_sinc(uint32_t cutoff, int32_t t);
+int64_t fixed_bessel_i0(uint32_t x);
+uint32_t fixed_sqrt(uint64_t x);
+void fixed_normalize(const int32_t* taps, int16_t* out, uint16_t count, uint8_t bits);
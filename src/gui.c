@@ -5,7 +5,10 @@
 #include "cpu.h"
 #include "dcimgui.h"
 #include "nes.h"
+#include "ntsc.h"
 #include "ppu.h"
+#include "scale.h"
+#include "viewer.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -255,38 +258,175 @@ static CNES_RESULT create_pipeline(_gui* gui) {
     return CNES_SUCCESS;
 }
 
-static void upload_texture(_gui* gui, _ppu* ppu, SDL_GPUCommandBuffer* cmdbuf) {
+static SDL_GPUTexture* upload_texture(_gui* gui, _ppu* ppu, SDL_GPUCommandBuffer* cmdbuf) {
     if (!gui || !gui->nes_transfer || !gui->nes_texture)
-        return;
+        return NULL;
+
+    uint8_t ntsc = gui->ntsc_enabled && ppu->format == PIXEL_INDEX16;
+    uint8_t scaled = !ntsc && gui->scaler && ppu->pixel_size == 4;
+
+    SDL_GPUTexture* texture = gui->nes_texture;
+    SDL_GPUTransferBuffer* transfer = gui->nes_transfer;
+    uint16_t w = NES_W;
+    uint16_t h = NES_H;
+
+    if (ntsc) {
+        texture = gui->ntsc_texture;
+        transfer = gui->ntsc_transfer;
+        w = NTSC_W;
+    } else if (scaled) {
+        texture = gui->scale_texture;
+        transfer = gui->scale_transfer;
+        w = NES_W * gui->scale_factor;
+        h = NES_H * gui->scale_factor;
+    }
 
-    uint32_t* dst = (uint32_t*)SDL_MapGPUTransferBuffer(gui->gpu_device, gui->nes_transfer, true);
-    if (!dst) return;
+    uint32_t* dst = (uint32_t*)SDL_MapGPUTransferBuffer(gui->gpu_device, transfer, true);
+    if (!dst) return texture;
 
-    memcpy(dst, ppu->pixels, NES_PIXELS * sizeof(uint32_t));
-    SDL_UnmapGPUTransferBuffer(gui->gpu_device, gui->nes_transfer);
+    if (ntsc) {
+        ntsc_filter(gui->ntsc, ppu->pixels, ppu->pitch, (uint8_t*)dst, NTSC_W * sizeof(uint32_t), ppu->burst_phase);
+    } else if (scaled) {
+        scale_frame(gui->scale, gui->scaler - 1, ppu->pixels, ppu->pitch, (uint8_t*)dst, w * sizeof(uint32_t));
+    } else {
+        for (uint16_t y = 0; y < NES_H; y++) {
+            memcpy(dst + y * NES_W, ppu->pixels + y * ppu->pitch, NES_W * sizeof(uint32_t));
+        }
+    }
+    SDL_UnmapGPUTransferBuffer(gui->gpu_device, transfer);
 
     SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass(cmdbuf);
-    if (!copy) return;
+    if (!copy) return texture;
 
     const SDL_GPUTextureTransferInfo xfer = {
-        .transfer_buffer = gui->nes_transfer,
+        .transfer_buffer = transfer,
         .offset = 0,
-        .pixels_per_row = NES_W,
-        .rows_per_layer = NES_H,
+        .pixels_per_row = w,
+        .rows_per_layer = h,
     };
     const SDL_GPUTextureRegion region = {
-        .texture = gui->nes_texture,
+        .texture = texture,
         .mip_level = 0,
         .layer = 0,
         .x = 0,
         .y = 0,
         .z = 0,
-        .w = NES_W,
-        .h = NES_H,
+        .w = w,
+        .h = h,
         .d = 1,
     };
     SDL_UploadToGPUTexture(copy, &xfer, &region, true);
     SDL_EndGPUCopyPass(copy);
+
+    return texture;
+}
+
+static CNES_RESULT create_frame_target(_gui* gui, uint16_t w, uint16_t h,
+                                       SDL_GPUTexture** texture, SDL_GPUTransferBuffer** transfer) {
+    const SDL_GPUTextureCreateInfo tinfo = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .width = w,
+        .height = h,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+    };
+
+    const SDL_GPUTransferBufferCreateInfo transfer_buffer = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = (uint32_t)w * h * sizeof(uint32_t),
+    };
+
+    if (!*texture) *texture = SDL_CreateGPUTexture(gui->gpu_device, &tinfo);
+    if (!*transfer) *transfer = SDL_CreateGPUTransferBuffer(gui->gpu_device, &transfer_buffer);
+    if (!*texture || !*transfer) {
+        fprintf(stderr, "[ERROR] Failed to create %ux%u frame texture: %s\n", w, h, SDL_GetError());
+        return CNES_FAILURE;
+    }
+
+    return CNES_SUCCESS;
+}
+
+static void release_frame_target(_gui* gui, SDL_GPUTexture** texture, SDL_GPUTransferBuffer** transfer) {
+    if (*transfer) {
+        SDL_ReleaseGPUTransferBuffer(gui->gpu_device, *transfer);
+        *transfer = NULL;
+    }
+
+    if (*texture) {
+        SDL_ReleaseGPUTexture(gui->gpu_device, *texture);
+        *texture = NULL;
+    }
+}
+
+static CNES_RESULT create_ntsc(_gui* gui) {
+    if (gui->ntsc) return CNES_SUCCESS;
+
+    if (create_frame_target(gui, NTSC_W, NTSC_H, &gui->ntsc_texture, &gui->ntsc_transfer) != CNES_SUCCESS)
+        return CNES_FAILURE;
+
+    gui->ntsc = (_ntsc*)SDL_malloc(sizeof(_ntsc));
+    if (!gui->ntsc || ntsc_init(gui->ntsc) != CNES_SUCCESS) {
+        fprintf(stderr, "[ERROR] Failed to initialize NTSC filter!\n");
+        SDL_free(gui->ntsc);
+        gui->ntsc = NULL;
+        return CNES_FAILURE;
+    }
+
+    return CNES_SUCCESS;
+}
+
+static void update_ntsc(_gui* gui, _nes* nes) {
+    if (gui->ntsc_request == gui->ntsc_enabled) return;
+
+    if (gui->ntsc_request && create_ntsc(gui) != CNES_SUCCESS) {
+        gui->ntsc_request = false;
+        return;
+    }
+
+    _pixel_format format = gui->ntsc_request ? PIXEL_INDEX16 : PIXEL_RGBA8888;
+    if (ppu_set_target(&nes->ppu, NULL, 0, format) == CNES_SUCCESS) {
+        gui->ntsc_enabled = gui->ntsc_request;
+    }
+}
+
+static void update_scaler(_gui* gui) {
+    if (gui->scaler_request == gui->scaler) return;
+
+    if (!gui->scaler_request) {
+        gui->scaler = 0;
+        return;
+    }
+
+    if (!gui->scale) {
+        gui->scale = (_scale*)SDL_malloc(sizeof(_scale));
+        if (!gui->scale || scale_init(gui->scale) != CNES_SUCCESS) {
+            fprintf(stderr, "[ERROR] Failed to initialize scaler!\n");
+            SDL_free(gui->scale);
+            gui->scale = NULL;
+            gui->scaler_request = 0;
+            return;
+        }
+    }
+
+    uint8_t factor = SCALER_FACTORS[gui->scaler_request - 1];
+    if (factor != gui->scale_factor) {
+        release_frame_target(gui, &gui->scale_texture, &gui->scale_transfer);
+        gui->scale_factor = 0;
+
+        if (create_frame_target(gui, NES_W * factor, NES_H * factor,
+                                &gui->scale_texture, &gui->scale_transfer) != CNES_SUCCESS) {
+            release_frame_target(gui, &gui->scale_texture, &gui->scale_transfer);
+            gui->scaler = gui->scaler_request = 0;
+            return;
+        }
+
+        gui->scale_factor = factor;
+    }
+
+    gui->scaler = gui->scaler_request;
 }
 
 static void draw_view_menu(_gui* gui) {
@@ -332,6 +472,37 @@ static void draw_view_menu(_gui* gui) {
             ImGui_EndCombo();
         }
 
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("NTSC FILTER");
+
+        ImGui_TableSetColumnIndex(1);
+        ImGui_Checkbox("##ntsc", &gui->ntsc_request);
+
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("SCALER");
+
+        ImGui_TableSetColumnIndex(1);
+        ImGui_SetNextItemWidth(-FLT_MIN);
+
+        if (gui->ntsc_request) ImGui_BeginDisabled(true);
+
+        const char* scaler = gui->scaler ? SCALER_NAMES[gui->scaler - 1] : "OFF";
+        if (ImGui_BeginCombo("##scaler", scaler, 0)) {
+            for (uint8_t i = 0; i <= SCALERS; i++) {
+                uint8_t selected = gui->scaler == i;
+                if (ImGui_SelectableEx(i ? SCALER_NAMES[i - 1] : "OFF", selected, 0, (ImVec2){0, 0}))
+                    gui->scaler_request = i;
+                if (selected) ImGui_SetItemDefaultFocus();
+            }
+            ImGui_EndCombo();
+        }
+
+        if (gui->ntsc_request) ImGui_EndDisabled();
+
         ImGui_TableNextRowEx(0, 0.0f);
         ImGui_TableSetColumnIndex(0);
         ImGui_AlignTextToFramePadding();
@@ -382,6 +553,96 @@ const char* format_bytes(size_t bytes, char* buffer, size_t buffer_size) {
     return buffer;
 }
 
+static const uint32_t AUDIO_RATES[] = { 44100, 48000, 96000 };
+
+static void draw_audio_menu(_nes* nes) {
+    _apu* apu = &nes->apu;
+
+    if (ImGui_BeginTable("AudioTable", 2, ImGuiTableFlags_SizingStretchProp)) {
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("SOUND");
+
+        ImGui_TableSetColumnIndex(1);
+        bool enabled = !apu->audio_off;
+        if (ImGui_Checkbox("##sound", &enabled)) {
+            apu_set_audio(apu, enabled);
+        }
+
+
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("SAMPLE RATE");
+
+        ImGui_TableSetColumnIndex(1);
+        ImGui_SetNextItemWidth(-FLT_MIN);
+
+        char preview[16];
+        snprintf(preview, sizeof(preview), "%u HZ", apu->sample_rate);
+
+        if (ImGui_BeginCombo("##sample_rate", preview, 0)) {
+            for (uint8_t i = 0; i < sizeof(AUDIO_RATES) / sizeof(AUDIO_RATES[0]); i++) {
+                char name[16];
+                snprintf(name, sizeof(name), "%u HZ", AUDIO_RATES[i]);
+                uint8_t selected = apu->sample_rate == AUDIO_RATES[i];
+
+                if (ImGui_SelectableEx(name, selected, 0, (ImVec2){0, 0}) && !selected) {
+                    apu_set_output(apu, AUDIO_RATES[i], (_audio_quality)apu->quality);
+                }
+
+                if (selected) ImGui_SetItemDefaultFocus();
+            }
+            ImGui_EndCombo();
+        }
+
+
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("RESAMPLER");
+
+        ImGui_TableSetColumnIndex(1);
+        ImGui_SetNextItemWidth(-FLT_MIN);
+
+        if (ImGui_BeginCombo("##resampler", AUDIO_QUALITY_NAMES[apu->quality], 0)) {
+            for (uint8_t i = 0; i < AUDIO_QUALITIES; i++) {
+                uint8_t selected = apu->quality == i;
+
+                if (ImGui_SelectableEx(AUDIO_QUALITY_NAMES[i], selected, 0, (ImVec2){0, 0}) && !selected) {
+                    apu_set_output(apu, apu->sample_rate, (_audio_quality)i);
+                }
+
+                if (selected) ImGui_SetItemDefaultFocus();
+            }
+            ImGui_EndCombo();
+        }
+
+
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("LATENCY");
+
+        ImGui_TableSetColumnIndex(1);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("%.1f MS (JITTER %.2f MS)", apu->stats.latency, apu->stats.jitter);
+
+
+        ImGui_TableNextRowEx(0, 0.0f);
+        ImGui_TableSetColumnIndex(0);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("RATE CONTROL\t");
+
+        ImGui_TableSetColumnIndex(1);
+        ImGui_AlignTextToFramePadding();
+        ImGui_Text("%+.3f%%, %u UNDERRUNS", (apu->stats.ratio - 1.0) * 100.0, apu->stats.underruns);
+
+        ImGui_EndTable();
+    }
+}
+
 static void draw_info_menu(_nes* nes) {
     if (ImGui_BeginTable("InfoTable", 2, ImGuiTableFlags_SizingStretchProp)) {
         ImGui_TableNextRowEx(0, 0.0f);
@@ -474,11 +735,21 @@ static void draw_main_menu(_gui* gui, _nes* nes) {
             ImGui_EndMenu();
         }
 
+        if (ImGui_BeginMenu("AUDIO")) {
+            draw_audio_menu(nes);
+            ImGui_EndMenu();
+        }
+
         if (ImGui_BeginMenu("INFO")) {
             draw_info_menu(nes);
             ImGui_EndMenu();
         }
 
+        if (ImGui_BeginMenu("DEBUG")) {
+            viewer_menu(&gui->viewers);
+            ImGui_EndMenu();
+        }
+
         ImGui_EndMainMenuBar();
     } else {
         gui->menu_height = 0.0f;
@@ -609,7 +880,8 @@ void gui_draw(_gui* gui, _nes* nes) {
     SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(gui->gpu_device);
     if (!cmdbuf) return;
 
-    upload_texture(gui, &nes->ppu, cmdbuf);
+    SDL_GPUTexture* frame_texture = upload_texture(gui, &nes->ppu, cmdbuf);
+    viewer_update(&gui->viewers, gui->gpu_device, cmdbuf, nes);
 
     SDL_GPUTexture* swapchain_tex = NULL;
     uint32_t sw = 0, sh = 0;
@@ -623,6 +895,7 @@ void gui_draw(_gui* gui, _nes* nes) {
     ImGui_NewFrame();
 
     draw_main_menu(gui, nes);
+    viewer_draw(&gui->viewers, gui->nes_sampler, nes);
 
     ImGui_Render();
     ImDrawData* draw_data = ImGui_GetDrawData();
@@ -670,7 +943,7 @@ void gui_draw(_gui* gui, _nes* nes) {
 
         SDL_GPUTextureSamplerBinding tex_binding;
         SDL_zero(tex_binding);
-        tex_binding.texture = gui->nes_texture;
+        tex_binding.texture = frame_texture ? frame_texture : gui->nes_texture;
         tex_binding.sampler = gui->nes_sampler;
 
         SDL_BindGPUFragmentSamplers(render_pass, 0, &tex_binding, 1);
@@ -702,6 +975,8 @@ void gui_draw(_gui* gui, _nes* nes) {
     SDL_SubmitGPUCommandBuffer(cmdbuf);
 
     record_frame_time(end_time);
+    update_ntsc(gui, nes);
+    update_scaler(gui);
 }
 
 void gui_deinit(_gui* gui) {
@@ -719,6 +994,10 @@ void gui_deinit(_gui* gui) {
         gui->im_ctx = NULL;
     }
 
+    if (gui->gpu_device) {
+        viewer_deinit(&gui->viewers, gui->gpu_device);
+    }
+
     if (gui->nes_pipeline) {
         SDL_ReleaseGPUGraphicsPipeline(gui->gpu_device, gui->nes_pipeline);
         gui->nes_pipeline = NULL;
@@ -739,6 +1018,22 @@ void gui_deinit(_gui* gui) {
         gui->nes_sampler = NULL;
     }
 
+    if (gui->ntsc) {
+        ntsc_deinit(gui->ntsc);
+        SDL_free(gui->ntsc);
+        gui->ntsc = NULL;
+    }
+
+    release_frame_target(gui, &gui->ntsc_texture, &gui->ntsc_transfer);
+
+    if (gui->scale) {
+        scale_deinit(gui->scale);
+        SDL_free(gui->scale);
+        gui->scale = NULL;
+    }
+
+    release_frame_target(gui, &gui->scale_texture, &gui->scale_transfer);
+
     if (gui->nes_transfer) {
         SDL_ReleaseGPUTransferBuffer(gui->gpu_device, gui->nes_transfer);
         gui->nes_transfer = NULL;
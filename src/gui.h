@@ -1,6 +1,9 @@
 #pragma once
 
 #include "nes.h"
+#include "ntsc.h"
+#include "scale.h"
+#include "viewer.h"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_gpu.h>
 #include <dcimgui.h>
@@ -43,12 +46,27 @@ typedef struct _gui {
     SDL_GPUShader* nes_fs;
     SDL_GPUGraphicsPipeline* nes_pipeline;
 
+    _ntsc* ntsc;
+    SDL_GPUTexture* ntsc_texture;
+    SDL_GPUTransferBuffer* ntsc_transfer;
+    uint8_t ntsc_enabled;
+    bool ntsc_request;
+
+    _scale* scale;
+    SDL_GPUTexture* scale_texture;
+    SDL_GPUTransferBuffer* scale_transfer;
+    uint8_t scale_factor;
+    uint8_t scaler;
+    uint8_t scaler_request;
+
     float menu_height;
 
     uint8_t quit;
 
     ImGuiContext* im_ctx;
     ImFont* nes_font;
+
+    _viewers viewers;
 } _gui;
 
 CNES_RESULT gui_init(_gui* gui);
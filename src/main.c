@@ -3,15 +3,15 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <SDL3/SDL.h>
 
 #define CNES_NO_STATS
 #define NES_REFRESH_RATE 60.0988138974405
 #define NES_FRAME_TIME_SEC (1.0 / NES_REFRESH_RATE)
 
-#define AUDIO_TARGET_QUEUED_BYTES (6144)
-#define AUDIO_SYNC_THRESHOLD (1024)
-#define MAX_ADJUSTMENT (0.0005)
+#define MAX_FRAMESKIP (3)
+#define FAST_FORWARD_FRAMES (4)
 
 static inline void print_build_info(void) {
     printf("[INFO] CNES BUILD:\n");
@@ -44,9 +44,191 @@ static uint8_t poll_controller_input(void) {
     return mask;
 }
 
+static uint8_t poll_fast_forward(void) {
+    const bool* state = SDL_GetKeyboardState(NULL);
+    return state[SDL_SCANCODE_TAB];
+}
+
+static void set_rom_path(_nes* nes, const char* path) {
+    if (path) {
+        size_t path_len = strlen(path) + 1;
+        nes->cart.rom_path = (char*)malloc(path_len);
+        strncpy(nes->cart.rom_path, path, path_len);
+    } else {
+        nes->cart.rom_path = NULL;
+    }
+}
+
+static CNES_RESULT attach_recording(_nes* nes, const char* path, const char* stems_path) {
+    if (path) {
+        _sink sink = sink_file(path);
+        if (apu_set_recorder(&nes->apu, &sink) != CNES_SUCCESS) return CNES_FAILURE;
+    }
+
+    if (stems_path) {
+        _sink sink = sink_file(stems_path);
+        if (apu_set_stems(&nes->apu, &sink) != CNES_SUCCESS) return CNES_FAILURE;
+    }
+
+    return CNES_SUCCESS;
+}
+
+// raw R8G8B8A8 frames, optionally run through a scaler or the NTSC filter into our own buffer
+typedef struct _capture {
+    FILE* file;
+    _ntsc* ntsc;
+    _scale* scale;
+    _scaler scaler;
+    uint8_t* frame;
+    size_t pitch;
+    uint16_t w;
+    uint16_t h;
+} _capture;
+
+static void capture_close(_capture* capture) {
+    if (capture->file) fclose(capture->file);
+    if (capture->ntsc) {
+        ntsc_deinit(capture->ntsc);
+        SDL_free(capture->ntsc);
+    }
+    if (capture->scale) {
+        scale_deinit(capture->scale);
+        SDL_free(capture->scale);
+    }
+    free(capture->frame);
+    memset(capture, 0, sizeof(_capture));
+}
+
+static CNES_RESULT capture_open(_capture* capture, const char* path, long scaler, uint8_t ntsc) {
+    memset(capture, 0, sizeof(_capture));
+    if (!path) return CNES_SUCCESS;
+
+    if (scaler < 0 || scaler > SCALERS) {
+        fprintf(stderr, "[ERROR] Unknown scaler %ld!\n", scaler);
+        return CNES_FAILURE;
+    }
+
+    if (ntsc) scaler = 0;
+
+    uint8_t factor = scaler ? SCALER_FACTORS[scaler - 1] : 1;
+    capture->w = ntsc ? NTSC_W : NES_W * factor;
+    capture->h = NES_H * factor;
+    capture->pitch = (size_t)capture->w * sizeof(uint32_t);
+    capture->frame = (uint8_t*)malloc(capture->pitch * capture->h);
+
+    if (ntsc) {
+        capture->ntsc = (_ntsc*)SDL_malloc(sizeof(_ntsc));
+        if (capture->ntsc && ntsc_init(capture->ntsc) != CNES_SUCCESS) {
+            SDL_free(capture->ntsc);
+            capture->ntsc = NULL;
+        }
+    } else if (scaler) {
+        capture->scaler = (_scaler)(scaler - 1);
+        capture->scale = (_scale*)SDL_malloc(sizeof(_scale));
+        if (capture->scale && scale_init(capture->scale) != CNES_SUCCESS) {
+            SDL_free(capture->scale);
+            capture->scale = NULL;
+        }
+    }
+
+    capture->file = fopen(path, "wb");
+    if (!capture->frame || (ntsc && !capture->ntsc) || (scaler && !capture->scale) || !capture->file) {
+        fprintf(stderr, "[ERROR] Could not open frame capture %s!\n", path);
+        capture_close(capture);
+        return CNES_FAILURE;
+    }
+
+    printf("[INFO] Capturing %ux%u RGBA frames to %s\n", capture->w, capture->h, path);
+    return CNES_SUCCESS;
+}
+
+static void capture_frame(_capture* capture, const _ppu* ppu) {
+    if (!capture->file) return;
+
+    if (capture->ntsc) {
+        ntsc_filter(capture->ntsc, ppu->pixels, ppu->pitch, capture->frame, capture->pitch, ppu->burst_phase);
+    } else if (capture->scale) {
+        scale_frame(capture->scale, capture->scaler, ppu->pixels, ppu->pitch, capture->frame, capture->pitch);
+    } else {
+        for (uint16_t y = 0; y < NES_H; y++) {
+            memcpy(capture->frame + y * capture->pitch, ppu->pixels + y * ppu->pitch, capture->pitch);
+        }
+    }
+
+    fwrite(capture->frame, capture->pitch, capture->h, capture->file);
+}
+
+// no window, no audio device and no throttling, just emulate, record and capture
+static int run_headless(const char* rom_path, const char* record_path, const char* stems_path,
+                        const char* capture_path, long scaler, uint8_t ntsc, long frames) {
+    if (!rom_path) {
+        fprintf(stderr, "[ERROR] Headless mode needs a ROM!\n");
+        return CNES_FAILURE;
+    }
+
+    static _nes nes;
+    set_rom_path(&nes, rom_path);
+
+    _capture capture;
+    if (nes_init(&nes) != CNES_SUCCESS || !nes.cart.loaded ||
+        attach_recording(&nes, record_path, stems_path) != CNES_SUCCESS ||
+        capture_open(&capture, capture_path, scaler, ntsc) != CNES_SUCCESS) {
+        nes_deinit(&nes);
+        return CNES_FAILURE;
+    }
+
+    if (capture.ntsc && ppu_set_target(&nes.ppu, NULL, 0, PIXEL_INDEX16) != CNES_SUCCESS) {
+        capture_close(&capture);
+        nes_deinit(&nes);
+        return CNES_FAILURE;
+    }
+
+    nes.ppu.no_output = !capture.file;
+
+    for (long frame = 0; frame < frames && !nes.cpu.halt; frame++) {
+        nes_clock(&nes);
+        apu_flush_audio(&nes.apu);
+        capture_frame(&capture, &nes.ppu);
+    }
+
+    capture_close(&capture);
+    nes_deinit(&nes);
+    return 0;
+}
+
 int main(int argc, char** argv) {
     print_build_info();
 
+    const char* rom_path = NULL;
+    const char* record_path = NULL;
+    const char* stems_path = NULL;
+    const char* capture_path = NULL;
+    long scaler = 0;
+    uint8_t ntsc = 0;
+    long headless_frames = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--stems") == 0 && i + 1 < argc) {
+            stems_path = argv[++i];
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else if (strcmp(argv[i], "--scaler") == 0 && i + 1 < argc) {
+            scaler = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ntsc") == 0) {
+            ntsc = 1;
+        } else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            headless_frames = strtol(argv[++i], NULL, 10);
+        } else {
+            rom_path = argv[i];
+        }
+    }
+
+    if (headless_frames >= 0) {
+        return run_headless(rom_path, record_path, stems_path, capture_path, scaler, ntsc, headless_frames);
+    }
+
     _gui gui;
     if (gui_init(&gui) != CNES_SUCCESS) {
         gui_deinit(&gui);
@@ -54,16 +236,12 @@ int main(int argc, char** argv) {
     }
 
     _nes nes;
-    if (argc > 1) {
-        size_t path_len = strlen(argv[1]) + 1;
-        nes.cart.rom_path = (char*)malloc(path_len);
-        strncpy(nes.cart.rom_path, argv[1], path_len);
+    set_rom_path(&nes, rom_path);
+    if (rom_path) {
         gui_set_title(&gui, &nes.cart);
-    } else {
-        nes.cart.rom_path = NULL;
     }
 
-    if (nes_init(&nes) != CNES_SUCCESS) {
+    if (nes_init(&nes) != CNES_SUCCESS || attach_recording(&nes, record_path, stems_path) != CNES_SUCCESS) {
         gui_deinit(&gui);
         nes_deinit(&nes);
         return CNES_FAILURE;
@@ -83,6 +261,9 @@ int main(int argc, char** argv) {
     double max_frame_time = 0.0;
     double min_frame_time = 1.0;
 
+    uint8_t skip_output = false;
+    uint8_t frameskip = 0;
+
     while (!nes.cpu.halt && !gui.quit) {
         if (nes.hard_reset_pending) {
             nes_hard_reset(&nes);
@@ -92,15 +273,8 @@ int main(int argc, char** argv) {
         uint64_t now = SDL_GetPerformanceCounter();
         int64_t remaining_ticks = (int64_t)next_frame_target - (int64_t)now;
 
-        double remaining_seconds = (double)remaining_ticks / perf_freq_dbl;
-
-        if (remaining_seconds > 0.002) {
-            uint32_t delay_ms = (uint32_t)((remaining_seconds - 0.001) * 1000.0);
-            SDL_Delay(delay_ms);
-            now = SDL_GetPerformanceCounter();
-        }
-
-        while (now < next_frame_target) {
+        if (remaining_ticks > 0) {
+            SDL_DelayPrecise((uint64_t)((double)remaining_ticks / perf_freq_dbl * 1e9));
             now = SDL_GetPerformanceCounter();
         }
 
@@ -156,22 +330,46 @@ int main(int argc, char** argv) {
 
         uint64_t work_start = SDL_GetPerformanceCounter();
 
-        if (nes.cart.loaded) {
-            nes_clock(&nes);
-            apu_flush_audio(&nes.apu);
+        if (!nes.cart.loaded) {
+            skip_output = false;
+        } else {
+            uint8_t frames = poll_fast_forward() ? FAST_FORWARD_FRAMES : 1;
+
+            for (uint8_t i = 0; i < frames; i++) {
+                uint8_t last = (i == frames - 1);
+
+                nes.ppu.no_output = !last || skip_output;
+                nes_clock(&nes);
+
+                if (last) {
+                    apu_flush_audio(&nes.apu);
+                } else {
+                    apu_discard_audio(&nes.apu);
+                }
+            }
         }
 
         uint64_t current_time = SDL_GetPerformanceCounter();
         uint64_t frame_deadline = next_frame_target + (uint64_t)(NES_FRAME_TIME_SEC * perf_freq_dbl);
 
-        uint8_t skip_draw = false;
-        if (current_time > frame_deadline) {
+        uint8_t skip_draw = skip_output;
+        uint8_t late = current_time > frame_deadline;
+
+        if (late) {
             skip_draw = true;
 #ifndef CNES_NO_STATS
             dropped_frames_stats++;
 #endif
         }
 
+        if (late && frameskip < MAX_FRAMESKIP) {
+            skip_output = true;
+            frameskip++;
+        } else {
+            skip_output = false;
+            frameskip = 0;
+        }
+
         if (!skip_draw) {
             gui_draw(&gui, &nes);
         }
@@ -182,21 +380,7 @@ int main(int argc, char** argv) {
         if (frame_work_time > max_frame_time) max_frame_time = frame_work_time;
         if (frame_work_time < min_frame_time) min_frame_time = frame_work_time;
 
-        double adjustment = 0.0;
-
-        if (nes.cart.loaded && nes.apu.audio_stream) {
-            int queued = SDL_GetAudioStreamQueued(nes.apu.audio_stream);
-            int diff = queued - AUDIO_TARGET_QUEUED_BYTES;
-
-            if (abs(diff) > AUDIO_SYNC_THRESHOLD) {
-                double correction = (double)diff * 0.0000001;
-                if (correction > MAX_ADJUSTMENT) correction = MAX_ADJUSTMENT;
-                if (correction < -MAX_ADJUSTMENT) correction = -MAX_ADJUSTMENT;
-                adjustment = correction;
-            }
-        }
-
-        next_frame_target += (uint64_t)((NES_FRAME_TIME_SEC + adjustment) * perf_freq_dbl);
+        next_frame_target += (uint64_t)(NES_FRAME_TIME_SEC * perf_freq_dbl);
         now = SDL_GetPerformanceCounter();
 
         uint64_t lag_threshold = (uint64_t)(NES_FRAME_TIME_SEC * 2.0 * perf_freq_dbl);
@@ -213,12 +397,14 @@ int main(int argc, char** argv) {
             double fps = frame_count_stats / time_since_stats;
             double avg_work = (max_frame_time + min_frame_time) / 2.0 * 1000.0;
 
-            printf("[STATS] FPS: %.2f | Drop: %llu | Jitter: %4.2fms | Work: %.2fms | AudioQ: %d B\n",
+            printf("[STATS] FPS: %.2f | Drop: %llu | Jitter: %4.2fms | Work: %.2fms | Audio: %.1fms +/- %.2fms x%.4f\n",
                    fps,
                    (unsigned long long)dropped_frames_stats,
                    max_jitter_ms,
                    avg_work,
-                   nes.apu.audio_stream ? SDL_GetAudioStreamQueued(nes.apu.audio_stream) : 0);
+                   nes.apu.stats.latency,
+                   nes.apu.stats.jitter,
+                   nes.apu.stats.ratio);
 
             last_stats_time = now;
             frame_count_stats = 0;
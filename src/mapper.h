@@ -8,15 +8,15 @@ extern _mapper mapper_table[256];
 
 #if defined(_MSC_VER)
     #pragma section(".CRT$XCU", read)
-    #define REGISTER_MAPPER(id, init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write) \
+    #define REGISTER_MAPPER(id, init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write, a12_rise) \
         static void register_mapper_##id(void) { \
-            mapper_table[id] = (_mapper){init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write, NULL}; \
+            mapper_table[id] = (_mapper){init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write, a12_rise, NULL}; \
         } \
         __declspec(allocate(".CRT$XCU")) void (*mapper_init_##id)(void) = register_mapper_##id;
 #elif defined(__GNUC__) || defined(__clang__)
-    #define REGISTER_MAPPER(id, init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write) \
+    #define REGISTER_MAPPER(id, init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write, a12_rise) \
         __attribute__((constructor)) static void register_mapper_##id(void) { \
-            mapper_table[id] = (_mapper){init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write, NULL}; \
+            mapper_table[id] = (_mapper){init, deinit, irq, cpu_read, cpu_write, ppu_read, ppu_write, a12_rise, NULL}; \
         }
 #else
     #error "Compiler not supported for mapper registration. Please use GCC/Clang/MSVC."
@@ -24,6 +24,3 @@ extern _mapper mapper_table[256];
 
 
 CNES_RESULT mapper_load(_cart* cart);
-
-// MISC
-void mmc3_scanline_tick(_cart* cart);
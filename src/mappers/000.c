@@ -71,5 +71,6 @@ REGISTER_MAPPER(0,
     map_cpu_read_0,
     map_cpu_write_0,
     map_ppu_read_0,
-    map_ppu_write_0
+    map_ppu_write_0,
+    NULL
 )
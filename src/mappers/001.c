@@ -12,10 +12,10 @@ typedef struct _mdata {
 void apply_control(_cart* cart, _mdata* mdata) {
     uint8_t m = mdata->control & 0x03;
     switch (m) {
-        case 0:     cart->mirror = MIRROR_SINGLE0;      break;
-        case 1:     cart->mirror = MIRROR_SINGLE1;      break;
-        case 2:     cart->mirror = MIRROR_VERTICAL;     break;
-        default:    cart->mirror = MIRROR_HORIZONTAL;   break;
+        case 0:     cart_set_mirror(cart, MIRROR_SINGLE0);      break;
+        case 1:     cart_set_mirror(cart, MIRROR_SINGLE1);      break;
+        case 2:     cart_set_mirror(cart, MIRROR_VERTICAL);     break;
+        default:    cart_set_mirror(cart, MIRROR_HORIZONTAL);   break;
     }
 }
 
@@ -34,6 +34,8 @@ void commit(_cart* cart, uint16_t addr) {
         mdata->prg_bank = value & 0x1F;
     }
 
+    if (addr <= 0xDFFF) cart->chr_gen++;
+
     mdata->load = 0;
     mdata->write_count = 0;
 }
@@ -202,5 +204,6 @@ REGISTER_MAPPER(1,
     map_cpu_read_1,
     map_cpu_write_1,
     map_ppu_read_1,
-    map_ppu_write_1
+    map_ppu_write_1,
+    NULL
 )
@@ -87,5 +87,6 @@ REGISTER_MAPPER(2,
     map_cpu_read_2,
     map_cpu_write_2,
     map_ppu_read_2,
-    map_ppu_write_2
+    map_ppu_write_2,
+    NULL
 )
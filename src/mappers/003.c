@@ -54,6 +54,7 @@ void map_cpu_write_3(_cart* cart, uint16_t addr, uint8_t data) {
     } else if (0x8000 <= addr && addr <= 0xFFFF) {
         _mdata* mdata = cart->mapper.data;
         mdata->chr_bank = data & (cart->chr_rom_banks - 1);
+        cart->chr_gen++;
     }
 }
 
@@ -92,5 +93,6 @@ REGISTER_MAPPER(3,
     map_cpu_read_3,
     map_cpu_write_3,
     map_ppu_read_3,
-    map_ppu_write_3
+    map_ppu_write_3,
+    NULL
 )
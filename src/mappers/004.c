@@ -41,6 +41,7 @@ void update_prg(_cart* cart, _mdata* mdata) {
 
 void update_chr(_cart* cart, _mdata* mdata) {
     uint8_t chr_mode = (mdata->bank_select >> 7) & 1;
+    cart->chr_gen++;
 
     uint32_t total_1k;
     if (cart->chr_rom.size) {
@@ -78,7 +79,7 @@ void update_chr(_cart* cart, _mdata* mdata) {
     }
 }
 
-void mmc3_scanline_tick(_cart* cart) {
+void map_a12_rise_4(_cart* cart) {
     _mdata* mdata = cart->mapper.data;
 
     if (mdata->irq_reload_flag || mdata->irq_counter == 0) {
@@ -173,7 +174,7 @@ void map_cpu_write_4(_cart* cart, uint16_t addr, uint8_t data) {
         if (addr & 1) {
             mdata->ram_protect = data;
         } else {
-            cart->mirror = (data & 1) ? MIRROR_HORIZONTAL : MIRROR_VERTICAL;
+            cart_set_mirror(cart, (data & 1) ? MIRROR_HORIZONTAL : MIRROR_VERTICAL);
         }
     } else if (addr >= 0xC000 && addr <= 0xDFFF) {
         if (addr & 1) {
@@ -231,5 +232,6 @@ REGISTER_MAPPER(4,
     map_cpu_read_4,
     map_cpu_write_4,
     map_ppu_read_4,
-    map_ppu_write_4
+    map_ppu_write_4,
+    map_a12_rise_4
 )
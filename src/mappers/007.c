@@ -10,7 +10,7 @@ CNES_RESULT map_init_7(_cart* cart) {
     cart->mapper.data = mdata;
 
     mdata->prg_bank = 0;
-    cart->mirror = MIRROR_SINGLE0;
+    cart_set_mirror(cart, MIRROR_SINGLE0);
     return CNES_SUCCESS;
 }
 
@@ -40,7 +40,7 @@ void map_cpu_write_7(_cart* cart, uint16_t addr, uint8_t data) {
     if (0x8000 <= addr && addr <= 0xFFFF) {
         _mdata* mdata = cart->mapper.data;
         mdata->prg_bank = (data & 0x07) & (cart->prg_rom_banks - 1);
-        cart->mirror = (data & 0x10) ? MIRROR_SINGLE1 : MIRROR_SINGLE0;
+        cart_set_mirror(cart, (data & 0x10) ? MIRROR_SINGLE1 : MIRROR_SINGLE0);
     }
 }
 
@@ -75,5 +75,6 @@ REGISTER_MAPPER(7,
     map_cpu_read_7,
     map_cpu_write_7,
     map_ppu_read_7,
-    map_ppu_write_7
+    map_ppu_write_7,
+    NULL
 )
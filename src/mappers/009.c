@@ -22,6 +22,8 @@ CNES_RESULT map_init_9(_cart* cart) {
 
     mdata->latch_low = LATCH_FD;
     mdata->latch_high = LATCH_FD;
+
+    cart->ppu_snoop = 1;
     return CNES_SUCCESS;
 }
 
@@ -81,7 +83,7 @@ void map_cpu_write_9(_cart* cart, uint16_t addr, uint8_t data) {
         mdata->chr_high_fe = data & 0x1F;
     }
     else if (0xF000 <= addr && addr <= 0xFFFF) {
-        cart->mirror = (data & 0x01) ? MIRROR_HORIZONTAL : MIRROR_VERTICAL;
+        cart_set_mirror(cart, (data & 0x01) ? MIRROR_HORIZONTAL : MIRROR_VERTICAL);
     }
 }
 
@@ -132,5 +134,6 @@ REGISTER_MAPPER(9,
     map_cpu_read_9,
     map_cpu_write_9,
     map_ppu_read_9,
-    map_ppu_write_9
+    map_ppu_write_9,
+    NULL
 )
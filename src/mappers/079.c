@@ -43,6 +43,7 @@ void map_cpu_write_79(_cart* cart, uint16_t addr, uint8_t data) {
         _mdata* mdata = cart->mapper.data;
         mdata->prg_bank = (data & 0x08) >> 3;
         mdata->chr_bank = data & 0x07;
+        cart->chr_gen++;
     }
 }
 
@@ -77,5 +78,6 @@ REGISTER_MAPPER(79,
     map_cpu_read_79,
     map_cpu_write_79,
     map_ppu_read_79,
-    map_ppu_write_79
+    map_ppu_write_79,
+    NULL
 )
@@ -46,6 +46,7 @@ void map_cpu_write_148(_cart* cart, uint16_t addr, uint8_t data) {
         _mdata* mdata = cart->mapper.data;
         mdata->prg_bank = (data & 0x08) >> 3;
         mdata->chr_bank = data & 0x07;
+        cart->chr_gen++;
     }
 }
 
@@ -78,5 +79,6 @@ REGISTER_MAPPER(148,
     map_cpu_read_148,
     map_cpu_write_148,
     map_ppu_read_148,
-    map_ppu_write_148
+    map_ppu_write_148,
+    NULL
 )
@@ -3,9 +3,11 @@
 #include "cnes.h"
 #include "cpu.h"
 #include "ppu.h"
+#include "reglog.h"
 #include <string.h>
 
-CNES_RESULT nes_init(_nes* nes) {
+// a hard reset re-attaches the sinks it kept, so it skips opening the audio device
+static CNES_RESULT init_nes(_nes* nes, uint8_t open_audio) {
     char* rom_path = nes->cart.rom_path;
     memset(nes, 0, sizeof(_nes));
 
@@ -17,6 +19,7 @@ CNES_RESULT nes_init(_nes* nes) {
     nes->ppu.p_cart = &nes->cart;
     nes->ppu.p_cpu = &nes->cpu;
     nes->cart.p_cpu = &nes->cpu;
+    nes->cart.ciram = nes->ppu.nametable;
 
     nes->cart.rom_path = rom_path;
 
@@ -24,6 +27,10 @@ CNES_RESULT nes_init(_nes* nes) {
         return CNES_FAILURE;
     }
 
+    if (open_audio) {
+        apu_open_device(&nes->apu);
+    }
+
     if (ppu_init(&nes->ppu) != CNES_SUCCESS) {
         return CNES_FAILURE;
     }
@@ -41,9 +48,16 @@ CNES_RESULT nes_init(_nes* nes) {
     return CNES_SUCCESS;
 }
 
+CNES_RESULT nes_init(_nes* nes) {
+    return init_nes(nes, 1);
+}
+
 void nes_deinit(_nes* nes) {
     apu_deinit(&nes->apu);
+    ppu_deinit(&nes->ppu);
     cart_unload(&nes->cart);
+    reglog_deinit(&nes->reglog);
+    nes->cpu.p_log = NULL;
 }
 
 void nes_soft_reset(_nes* nes) {
@@ -56,53 +70,179 @@ void nes_soft_reset(_nes* nes) {
 }
 
 void nes_hard_reset(_nes* nes) {
+    _ppu* ppu = &nes->ppu;
+    uint8_t* target = ppu->pixels != ppu->own_pixels ? ppu->pixels : NULL;
+    size_t pitch = ppu->pitch;
+    uint8_t format = ppu->format;
+    uint32_t rate = nes->apu.sample_rate;
+    uint8_t quality = nes->apu.quality;
+    uint8_t audio_off = nes->apu.audio_off;
+
+    // keep the attached sinks open across the re-init
+    _sink sink = nes->apu.sink;
+    _sink recorder = nes->apu.recorder;
+    _apu_stems* stems = nes->apu.stems;
+    nes->apu.sink = sink_null();
+    nes->apu.recorder = sink_null();
+    nes->apu.stems = NULL;
+
     nes_deinit(nes);
-    nes_init(nes);
+    init_nes(nes, 0);
     nes->hard_reset_pending = 0;
+
+    sink_close(&nes->apu.sink);
+    nes->apu.sink = sink;
+    nes->apu.recorder = recorder;
+    nes->apu.stems = stems;
+
+    // also rebuilds the stems so they stay in phase with the fresh mix
+    apu_set_output(&nes->apu, rate, quality);
+
+    if (audio_off) {
+        apu_set_audio(&nes->apu, 0);
+    }
+
+    if (target || format != PIXEL_RGBA8888) {
+        ppu_set_target(ppu, target, pitch, format);
+    }
 }
 
-void nes_clock(_nes* nes) {
-    uint8_t frame_complete = 0;
+static size_t sched_update(_nes* nes, size_t target) {
+    _sched* sched = &nes->sched;
+    size_t now = nes->master_clock;
+
+    sched->at[EVENT_PPU] = now + nes->ppu.idle_dots / 3;
+    sched->at[EVENT_DMA] = (nes->ppu.dma.is_transfer || nes->apu.dmc.dma_active) ? now : SIZE_MAX;
+    sched->at[EVENT_APU] = now + nes->apu.horizon - nes->apu.cycle_debt - 1;
+    sched->at[EVENT_TARGET] = target;
+
+    sched->next = SIZE_MAX;
+    for (uint8_t e = 0; e < EVENTS; e++) {
+        if (sched->at[e] < sched->next) sched->next = sched->at[e];
+    }
+
+    return sched->next;
+}
+
+static void nes_run_quiet(_nes* nes, size_t end) {
+    _cpu* cpu = &nes->cpu;
+    _apu* apu = &nes->apu;
+    uint8_t mapper_irq = nes->cart.mapper.irq_pending(&nes->cart);
+
+    cpu->io_access = 0;
+
+    while (nes->master_clock < end && !cpu->io_access) {
+        nes->ppu.idle_dots -= 3;
+        nes->ppu.dot_debt += 3;
+
+        apu->cycle_debt++;
+
+        cpu->irq_pending = apu->frame_counter_irq || apu->dmc.irq_pending || mapper_irq;
+        cpu_clock(cpu);
+
+        nes->master_clock++;
+    }
+}
+
+static CNES_RESULT nes_step(_nes* nes) {
+    CNES_RESULT frame_complete = 0;
+
+    if (nes->ppu.idle_dots >= 3) {
+        nes->ppu.idle_dots -= 3;
+        nes->ppu.dot_debt += 3;
+    } else {
+        ppu_sync(&nes->ppu);
 
-    while (!frame_complete) {
         frame_complete =
             ppu_clock(&nes->ppu) |
             ppu_clock(&nes->ppu) |
             ppu_clock(&nes->ppu);
 
-        apu_clock(&nes->apu);
+        if (nes->ppu.cycle < 3 || nes->ppu.scanline >= NES_H) {
+            nes->ppu.idle_dots = ppu_idle_span(&nes->ppu);
+        }
+    }
 
-        if (nes->apu.dmc.dma_active) {
-            if (--nes->apu.dmc.dma_cycles_left == 0) {
-                dmc_dma_complete(&nes->apu);
-                nes->apu.dmc.dma_active = 0;
-            }
-        } else if (nes->ppu.dma.is_transfer) {
-            if (nes->ppu.dma.dummy_cycle) {
-                if (nes->master_clock & 1)
-                    nes->ppu.dma.dummy_cycle = 0;
-            } else {
-                if (nes->master_clock & 1) {
-                    ((uint8_t*)nes->ppu.oam)[nes->ppu.dma.addr++] = nes->ppu.dma.data;
-
-                    if (!nes->ppu.dma.addr) {
-                        nes->ppu.dma.is_transfer = 0;
-                        nes->ppu.dma.dummy_cycle = 1;
-                    }
-                } else {
-                    nes->ppu.dma.data = cpu_read(
-                        &nes->cpu,
-                        (nes->ppu.dma.page << 8) | nes->ppu.dma.addr
-                    );
+    if (++nes->apu.cycle_debt >= nes->apu.horizon || nes->apu.dmc.dma_active) {
+        apu_sync(&nes->apu);
+    }
+
+    if (nes->apu.dmc.dma_active) {
+        if (--nes->apu.dmc.dma_cycles_left == 0) {
+            dmc_dma_complete(&nes->apu);
+            nes->apu.dmc.dma_active = 0;
+        }
+    } else if (nes->ppu.dma.is_transfer) {
+        if (nes->ppu.dma.dummy_cycle) {
+            if (nes->master_clock & 1)
+                nes->ppu.dma.dummy_cycle = 0;
+        } else {
+            if (nes->master_clock & 1) {
+                ((uint8_t*)nes->ppu.oam)[nes->ppu.dma.addr++] = nes->ppu.dma.data;
+
+                if (!nes->ppu.dma.addr) {
+                    nes->ppu.dma.is_transfer = 0;
+                    nes->ppu.dma.dummy_cycle = 1;
                 }
+            } else {
+                nes->ppu.dma.data = cpu_read(
+                    &nes->cpu,
+                    (nes->ppu.dma.page << 8) | nes->ppu.dma.addr
+                );
             }
-        } else {
-            nes->cpu.irq_pending = (nes->apu.frame_counter_irq || nes->apu.dmc.irq_pending) ||
-                    (nes->cart.mapper.irq_pending(&nes->cart));
+        }
+    } else {
+        nes->cpu.irq_pending = (nes->apu.frame_counter_irq || nes->apu.dmc.irq_pending) ||
+                (nes->cart.mapper.irq_pending(&nes->cart));
+
+        cpu_clock(&nes->cpu);
+    }
+
+    nes->master_clock++;
+
+    return frame_complete;
+}
+
+static CNES_RESULT nes_run(_nes* nes, size_t target, uint8_t stop_at_frame) {
+    CNES_RESULT frame_complete = 0;
 
-            cpu_clock(&nes->cpu);
+    while (nes->master_clock < target) {
+        if (sched_update(nes, target) > nes->master_clock) {
+            nes_run_quiet(nes, nes->sched.next);
+            continue;
         }
 
-        nes->master_clock++;
+        if (nes_step(nes)) {
+            if (nes->cpu.p_log) reglog_end_frame(nes->cpu.p_log);
+            ppu_raster_end_frame(&nes->ppu);
+            frame_complete = 1;
+            if (stop_at_frame) break;
+        }
+    }
+
+    // a mid-frame return only needs the lines so far, the frame keeps going on the next call
+    ppu_raster_wait(&nes->ppu);
+
+    return frame_complete;
+}
+
+void nes_clock(_nes* nes) {
+    nes_run(nes, SIZE_MAX, 1);
+}
+
+CNES_RESULT nes_run_until(_nes* nes, size_t target) {
+    return nes_run(nes, target, 0);
+}
+
+void nes_set_reglog(_nes* nes, uint8_t enabled) {
+    if (!enabled) {
+        nes->cpu.p_log = NULL;
+        return;
+    }
+
+    if (nes->cpu.p_log) return;
+
+    if (reglog_init(&nes->reglog) == CNES_SUCCESS) {
+        nes->cpu.p_log = &nes->reglog;
     }
 }
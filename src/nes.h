@@ -4,6 +4,20 @@
 #include "cpu.h"
 #include "input.h"
 #include "ppu.h"
+#include "reglog.h"
+
+typedef enum _event {
+    EVENT_PPU,
+    EVENT_DMA,
+    EVENT_APU,
+    EVENT_TARGET,
+    EVENTS,
+} _event;
+
+typedef struct _sched {
+    size_t at[EVENTS];
+    size_t next;
+} _sched;
 
 typedef struct _nes {
     _cpu cpu;
@@ -11,7 +25,9 @@ typedef struct _nes {
     _apu apu;
     _cart cart;
     _input input;
+    _reglog reglog;
 
+    _sched sched;
     size_t master_clock;
     uint8_t hard_reset_pending;
 } _nes;
@@ -21,3 +37,5 @@ void nes_deinit(_nes* nes);
 void nes_soft_reset(_nes* nes);
 void nes_hard_reset(_nes* nes);
 void nes_clock(_nes* nes);
+CNES_RESULT nes_run_until(_nes* nes, size_t target);
+void nes_set_reglog(_nes* nes, uint8_t enabled);
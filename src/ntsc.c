@@ -0,0 +1,186 @@
+#include "ntsc.h"
+#include "cnes.h"
+#include "ppu.h"
+#include "simd.h"
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NTSC_BLACK  0.312f
+#define NTSC_WHITE  1.100f
+#define NTSC_HUE    3.9f
+#define NTSC_SAT    1.5f
+
+static const float NTSC_LEVELS[4][4] = {
+    { 0.228f, 0.312f, 0.552f, 0.880f },
+    { 0.616f, 0.840f, 1.100f, 1.100f },
+    { 0.192f, 0.256f, 0.448f, 0.712f },
+    { 0.494f, 0.676f, 0.880f, 0.880f },
+};
+
+static uint8_t in_color_phase(uint8_t color, uint8_t phase) {
+    return (color + phase) % 12 < 6;
+}
+
+static float ntsc_signal(uint16_t pixel, uint8_t phase) {
+    uint8_t color = pixel & 0x0F;
+    uint8_t level = (pixel >> 4) & 0x03;
+    uint8_t emphasis = (pixel >> 6) & 0x07;
+
+    if (color > 13) level = 1;
+
+    uint8_t attenuate =
+        ((emphasis & 0x01) && in_color_phase(0, phase)) ||
+        ((emphasis & 0x02) && in_color_phase(4, phase)) ||
+        ((emphasis & 0x04) && in_color_phase(8, phase));
+
+    float low = NTSC_LEVELS[attenuate ? 2 : 0][level];
+    float high = NTSC_LEVELS[attenuate ? 3 : 1][level];
+
+    if (color == 0) low = high;
+    if (color > 12) high = low;
+
+    float signal = in_color_phase(color, phase) ? high : low;
+    return (signal - NTSC_BLACK) / (NTSC_WHITE - NTSC_BLACK);
+}
+
+static void build_kernel(_ntsc* ntsc) {
+    memset(ntsc->kernel, 0, sizeof(ntsc->kernel));
+
+    for (uint8_t p = 0; p < NTSC_PHASES; p++) {
+        for (uint16_t pixel = 0; pixel < NTSC_COLORS; pixel++) {
+            for (uint8_t n = 0; n < 8; n++) {
+                uint8_t phase = (uint8_t)((p * 4 + n) % 12);
+                float s = ntsc_signal(pixel, phase) / 12.0f;
+                float angle = SDL_PI_F * ((float)phase + NTSC_HUE) / 6.0f;
+
+                float y = s;
+                float i = s * SDL_cosf(angle) * NTSC_SAT;
+                float q = s * SDL_sinf(angle) * NTSC_SAT;
+
+                float r = y + 0.946882f * i + 0.623557f * q;
+                float g = y - 0.274788f * i - 0.635691f * q;
+                float b = y - 1.108545f * i + 1.709007f * q;
+
+                for (int8_t k = -1; k < NTSC_TAPS - 1; k++) {
+                    if (n < 4 * k - 4 || n >= 4 * k + 8) continue;
+
+                    float* out = ntsc->kernel[p][pixel][k + 1];
+                    out[0] += r;
+                    out[1] += g;
+                    out[2] += b;
+                }
+            }
+        }
+    }
+}
+
+#if defined(CNES_SSE2)
+
+typedef __m128 ntsc_vec;
+
+static inline ntsc_vec vec_zero(void) { return _mm_setzero_ps(); }
+static inline ntsc_vec vec_load(const float* p) { return _mm_loadu_ps(p); }
+static inline ntsc_vec vec_add(ntsc_vec a, ntsc_vec b) { return _mm_add_ps(a, b); }
+
+static inline uint32_t vec_pack(ntsc_vec v) {
+    __m128i c = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.0f)));
+    c = _mm_packs_epi32(c, c);
+    c = _mm_packus_epi16(c, c);
+    return (uint32_t)_mm_cvtsi128_si32(c) | 0xFF000000;
+}
+
+#elif defined(CNES_NEON)
+
+typedef float32x4_t ntsc_vec;
+
+static inline ntsc_vec vec_zero(void) { return vdupq_n_f32(0.0f); }
+static inline ntsc_vec vec_load(const float* p) { return vld1q_f32(p); }
+static inline ntsc_vec vec_add(ntsc_vec a, ntsc_vec b) { return vaddq_f32(a, b); }
+
+static inline uint32_t vec_pack(ntsc_vec v) {
+    uint32x4_t c = vcvtq_u32_f32(vminq_f32(vmaxq_f32(vmulq_n_f32(v, 255.0f), vdupq_n_f32(0.0f)),
+                                           vdupq_n_f32(255.0f)));
+    uint16x4_t h = vmovn_u32(c);
+    uint8x8_t b = vmovn_u16(vcombine_u16(h, h));
+    return vget_lane_u32(vreinterpret_u32_u8(b), 0) | 0xFF000000;
+}
+
+#else
+
+typedef struct ntsc_vec { float v[4]; } ntsc_vec;
+
+static inline ntsc_vec vec_zero(void) { return (ntsc_vec){ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+static inline ntsc_vec vec_load(const float* p) { return (ntsc_vec){ { p[0], p[1], p[2], p[3] } }; }
+
+static inline ntsc_vec vec_add(ntsc_vec a, ntsc_vec b) {
+    for (uint8_t i = 0; i < 4; i++) a.v[i] += b.v[i];
+    return a;
+}
+
+static inline uint32_t vec_pack(ntsc_vec v) {
+    uint32_t out = 0xFF000000;
+    for (uint8_t i = 0; i < 3; i++) {
+        float c = v.v[i] * 255.0f + 0.5f;
+        uint32_t u = c <= 0.0f ? 0 : c >= 255.0f ? 255 : (uint32_t)c;
+        out |= u << (i * 8);
+    }
+    return out;
+}
+
+#endif
+
+static void ntsc_row(_ntsc* ntsc, const uint16_t* in, uint32_t* out, uint8_t phase) {
+    ntsc_vec acc[NTSC_W + NTSC_TAPS];
+
+    for (uint16_t o = 0; o < NTSC_W + NTSC_TAPS; o++) {
+        acc[o] = vec_zero();
+    }
+
+    for (uint16_t x = 0; x < NES_W; x++) {
+        float (*k)[4] = ntsc->kernel[phase][in[x] & (NTSC_COLORS - 1)];
+        ntsc_vec* a = acc + x * 2;
+
+        a[0] = vec_add(a[0], vec_load(k[0]));
+        a[1] = vec_add(a[1], vec_load(k[1]));
+        a[2] = vec_add(a[2], vec_load(k[2]));
+        a[3] = vec_add(a[3], vec_load(k[3]));
+
+        phase = phase == 0 ? 2 : phase - 1;
+    }
+
+    for (uint16_t o = 0; o < NTSC_W; o++) {
+        out[o] = vec_pack(acc[o + 1]);
+    }
+}
+
+static void ntsc_rows(void* data, uint16_t first, uint16_t last) {
+    _ntsc* ntsc = (_ntsc*)data;
+
+    for (uint16_t y = first; y < last; y++) {
+        const uint16_t* in = (const uint16_t*)(ntsc->in + y * ntsc->in_pitch);
+        uint32_t* out = (uint32_t*)(ntsc->out + y * ntsc->out_pitch);
+        ntsc_row(ntsc, in, out, (uint8_t)((ntsc->burst + y) % NTSC_PHASES));
+    }
+}
+
+CNES_RESULT ntsc_init(_ntsc* ntsc) {
+    memset(ntsc, 0, sizeof(_ntsc));
+    build_kernel(ntsc);
+    pool_init(&ntsc->pool, "ntsc", NTSC_H, ntsc_rows, ntsc);
+    return CNES_SUCCESS;
+}
+
+void ntsc_deinit(_ntsc* ntsc) {
+    pool_deinit(&ntsc->pool);
+}
+
+void ntsc_filter(_ntsc* ntsc, const uint8_t* in, size_t in_pitch, uint8_t* out, size_t out_pitch, uint8_t burst) {
+    ntsc->burst = burst % NTSC_PHASES;
+    ntsc->in = in;
+    ntsc->in_pitch = in_pitch;
+    ntsc->out = out;
+    ntsc->out_pitch = out_pitch;
+
+    pool_run(&ntsc->pool);
+}
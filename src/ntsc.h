@@ -0,0 +1,28 @@
+#pragma once
+#include "cnes.h"
+#include "pool.h"
+#include "ppu.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define NTSC_W          (NES_W * 2)
+#define NTSC_H          NES_H
+#define NTSC_PHASES     NES_BURST_PHASES
+#define NTSC_COLORS     0x200
+#define NTSC_TAPS       4
+
+typedef struct _ntsc {
+    float kernel[NTSC_PHASES][NTSC_COLORS][NTSC_TAPS][4];
+
+    _pool pool;
+
+    const uint8_t* in;
+    size_t in_pitch;
+    uint8_t* out;
+    size_t out_pitch;
+    uint8_t burst;
+} _ntsc;
+
+CNES_RESULT ntsc_init(_ntsc* ntsc);
+void ntsc_deinit(_ntsc* ntsc);
+void ntsc_filter(_ntsc* ntsc, const uint8_t* in, size_t in_pitch, uint8_t* out, size_t out_pitch, uint8_t burst);
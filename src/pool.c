@@ -0,0 +1,120 @@
+#include "pool.h"
+#include "cnes.h"
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+static int pool_worker(void* data) {
+    _pool_worker* worker = (_pool_worker*)data;
+    _pool* pool = worker->pool;
+    uint32_t seen = 0;
+
+    SDL_LockMutex(pool->lock);
+
+    while (!pool->quit) {
+        if (pool->generation == seen) {
+            SDL_WaitCondition(pool->wake, pool->lock);
+            continue;
+        }
+
+        seen = pool->generation;
+        SDL_UnlockMutex(pool->lock);
+
+        pool->rows(pool->data, worker->first, worker->last);
+
+        SDL_LockMutex(pool->lock);
+        if (--pool->pending == 0) {
+            SDL_SignalCondition(pool->done);
+        }
+    }
+
+    SDL_UnlockMutex(pool->lock);
+    return 0;
+}
+
+// without spare cores, or if the threads don't start, every band runs inline on the caller
+void pool_init(_pool* pool, const char* name, uint16_t height, _pool_rows rows, void* data) {
+    memset(pool, 0, sizeof(_pool));
+    pool->rows = rows;
+    pool->data = data;
+    pool->height = height;
+
+    int cores = SDL_GetNumLogicalCPUCores();
+    uint8_t count = cores > POOL_THREADS ? POOL_THREADS : (cores > 1 ? (uint8_t)(cores - 1) : 0);
+    if (!count) return;
+
+    pool->lock = SDL_CreateMutex();
+    pool->wake = SDL_CreateCondition();
+    pool->done = SDL_CreateCondition();
+
+    if (!pool->lock || !pool->wake || !pool->done) {
+        fprintf(stderr, "[ERROR] Failed to start %s worker threads, running inline!\n", name);
+        pool_deinit(pool);
+        return;
+    }
+
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "cnes %s", name);
+    uint16_t band = height / (count + 1);
+
+    for (uint8_t i = 0; i < count; i++) {
+        _pool_worker* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->first = (uint16_t)(band * (i + 1));
+        worker->last = i == count - 1 ? height : (uint16_t)(band * (i + 2));
+
+        worker->thread = SDL_CreateThread(pool_worker, thread_name, worker);
+        if (!worker->thread) {
+            fprintf(stderr, "[ERROR] Failed to start %s worker threads, running inline!\n", name);
+            pool_deinit(pool);
+            return;
+        }
+
+        pool->worker_count++;
+    }
+}
+
+void pool_deinit(_pool* pool) {
+    if (pool->worker_count) {
+        SDL_LockMutex(pool->lock);
+        pool->quit = 1;
+        SDL_BroadcastCondition(pool->wake);
+        SDL_UnlockMutex(pool->lock);
+
+        for (uint8_t i = 0; i < pool->worker_count; i++) {
+            SDL_WaitThread(pool->workers[i].thread, NULL);
+            pool->workers[i].thread = NULL;
+        }
+
+        pool->worker_count = 0;
+    }
+
+    if (pool->done) SDL_DestroyCondition(pool->done);
+    if (pool->wake) SDL_DestroyCondition(pool->wake);
+    if (pool->lock) SDL_DestroyMutex(pool->lock);
+
+    pool->done = NULL;
+    pool->wake = NULL;
+    pool->lock = NULL;
+}
+
+void pool_run(_pool* pool) {
+    if (!pool->worker_count) {
+        pool->rows(pool->data, 0, pool->height);
+        return;
+    }
+
+    SDL_LockMutex(pool->lock);
+    pool->pending = pool->worker_count;
+    pool->generation++;
+    SDL_BroadcastCondition(pool->wake);
+    SDL_UnlockMutex(pool->lock);
+
+    pool->rows(pool->data, 0, pool->workers[0].first);
+
+    SDL_LockMutex(pool->lock);
+    while (pool->pending) {
+        SDL_WaitCondition(pool->done, pool->lock);
+    }
+    SDL_UnlockMutex(pool->lock);
+}
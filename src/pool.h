@@ -0,0 +1,40 @@
+#pragma once
+#include "cnes.h"
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <stdint.h>
+
+#define POOL_THREADS 4
+
+typedef struct _pool _pool;
+
+// filters a band of rows [first, last) of the current job
+typedef void (*_pool_rows)(void* data, uint16_t first, uint16_t last);
+
+typedef struct _pool_worker {
+    _pool* pool;
+    SDL_Thread* thread;
+    uint16_t first;
+    uint16_t last;
+} _pool_worker;
+
+// splits a frame into row bands, the caller takes the first band and waits for the rest
+typedef struct _pool {
+    _pool_worker workers[POOL_THREADS];
+    uint8_t worker_count;
+
+    SDL_Mutex* lock;
+    SDL_Condition* wake;
+    SDL_Condition* done;
+    uint32_t generation;
+    uint8_t pending;
+    uint8_t quit;
+
+    _pool_rows rows;
+    void* data;
+    uint16_t height;
+} _pool;
+
+void pool_init(_pool* pool, const char* name, uint16_t height, _pool_rows rows, void* data);
+void pool_deinit(_pool* pool);
+void pool_run(_pool* pool);
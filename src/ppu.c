@@ -4,9 +4,13 @@
 #include "cart.h"
 #include "mapper.h"
 #include "palette.h"
+#include "raster.h"
 #include <string.h>
 #include <stdio.h>
 
+static uint8_t line_type[NES_ALL_HMAX + 1];
+static uint32_t dot_actions[LINE_TYPES][NES_ALL_WMAX + 1];
+
 static inline void ppu_bus_set(_ppu* ppu, uint8_t value) {
     ppu->ppudata = value;
     ppu->bus_decay = 0x8000;
@@ -21,6 +25,19 @@ static inline void ppu_bus_decay(_ppu* ppu) {
     }
 }
 
+static inline void ppu_watch_a12(_ppu* ppu, uint16_t addr) {
+    uint8_t a12 = (addr & 0x1000) != 0;
+    if (a12 == ppu->a12) return;
+
+    ppu->a12 = a12;
+
+    if (!a12) {
+        ppu->a12_low_since = ppu->dots;
+    } else if (ppu->dots - ppu->a12_low_since >= A12_LOW_FILTER) {
+        ppu->p_cart->mapper.a12_rise(ppu->p_cart);
+    }
+}
+
 static inline uint8_t render_enabled(_ppu* ppu) {
     return ppu->ppumask & (BGRND_EN | SPRITE_EN);
 }
@@ -56,13 +73,11 @@ CNES_RESULT ppu_clock(_ppu* ppu) {
 
     const int scanline = ppu->scanline;
     const int cycle = ppu->cycle;
+    const uint32_t actions = dot_actions[line_type[scanline]][cycle];
 
     const uint8_t rendering = render_enabled(ppu);
-    const uint8_t visible_scanline = (scanline < NES_H);
-    const uint8_t pre_render_scanline = (scanline == NES_ALL_HMAX);
-    const uint8_t render_or_prerender = (pre_render_scanline || visible_scanline);
 
-    if (pre_render_scanline && cycle == 1) {
+    if (actions & DOT_VBL_CLEAR) {
         ppu->ppustatus &= ~(VBLANK | SPRITE_0_HIT | SPRITE_OVERFLOW);
         ppu->suppress_vbl_flag = 0;
         ppu->nmi_forced = 0;
@@ -72,7 +87,7 @@ CNES_RESULT ppu_clock(_ppu* ppu) {
         memset(ppu->sprite_pattern_high, 0x00, sizeof(ppu->sprite_pattern_high));
     }
 
-    if (scanline == 241 && cycle == 1) {
+    if (actions & DOT_VBL_SET) {
         if (ppu->suppress_vbl_flag) {
             ppu->suppress_vbl_flag = 0;
         } else {
@@ -80,264 +95,255 @@ CNES_RESULT ppu_clock(_ppu* ppu) {
             ppu_update_nmi_state(ppu);
         }
         frame_complete = 1;
-    } else if (ppu->suppress_vbl_flag && (scanline == 241 && cycle > 1)) {
+    } else if (ppu->suppress_vbl_flag && (actions & DOT_VBL_LATE)) {
         ppu->suppress_vbl_flag = 0;
     }
 
-    if (render_or_prerender && rendering && cycle == 260 && ppu->p_cart) {
-        if (ppu->p_cart->mapper_id == 4) {
-            mmc3_scanline_tick(ppu->p_cart);
-        }
-    }
-
-    if (render_or_prerender) {
-        uint8_t in_visible_fetch_range = (cycle >= 2 && cycle <= 257);
-        uint8_t in_blank_fetch_range = (cycle >= 321 && cycle <= 337);
-
-        if (in_visible_fetch_range || in_blank_fetch_range) {
-            update_shifters(ppu);
-
-            if (rendering) {
-                uint8_t stage = (uint8_t)((cycle - 1) & 0x07);
-
-                if (stage == 0) {
-                    load_bgrnd_shifters(ppu);
-                    ppu->bgrnd_next_id = ppu_read(ppu, 0x2000 | (ppu->vram_addr & 0x0FFF));
-                } else if (stage == 2) {
-                    uint16_t v = ppu->vram_addr;
-                    ppu->bgrnd_next_attr = ppu_read(
-                        ppu,
-                        0x23C0 |
-                        (v & (NTBL_Y | NTBL_X)) |
-                        ((v >> 4) & 0x38) |
-                        ((v >> 2) & 0x07)
-                    );
-
-                    if (v & 0x0040) ppu->bgrnd_next_attr >>= 4;
-                    if (v & 0x0002) ppu->bgrnd_next_attr >>= 2;
-                    ppu->bgrnd_next_attr &= 0x03;
-                } else if (stage == 4) {
-                    ppu->bgrnd_next_low = ppu_read(
-                        ppu,
-                        ((uint16_t)(ppu->ppuctrl & BGRND_SEL) << 8) |
-                        ((uint16_t)ppu->bgrnd_next_id << 4) |
-                        ((ppu->vram_addr & FINE_Y) >> 12)
-                    );
-                } else if (stage == 6) {
-                    ppu->bgrnd_next_high = ppu_read(
-                        ppu,
-                        (((uint16_t)(ppu->ppuctrl & BGRND_SEL) << 8) |
-                        ((uint16_t)ppu->bgrnd_next_id << 4) |
-                        ((ppu->vram_addr & FINE_Y) >> 12)) + 8
-                    );
-                } else if (stage == 7) {
-                    increment_scroll_x(ppu);
-                }
-            }
-        }
+    if (actions & DOT_MEMO_BEGIN) {
+        bgrnd_memo_begin(ppu);
+    }
 
-        if (cycle == NES_W) {
-            increment_scroll_y(ppu);
-        }
+    if (actions & DOT_RASTER_BEGIN) {
+        ppu_raster_begin(ppu);
+    }
 
-        if (cycle == NES_W + 1) {
-            load_bgrnd_shifters(ppu);
-            transfer_addr_x(ppu);
-        }
+    if (actions & DOT_SPRITE_0) {
+        sprite_0_begin(ppu);
+    }
 
-        if (rendering && (cycle == 338 || cycle == 340)) {
-            ppu->bgrnd_next_id = ppu_read(ppu, 0x2000 | (ppu->vram_addr & 0x0FFF));
+    if (actions & DOT_SHIFT) {
+        if (ppu->memo_state != MEMO_REPLAY) {
+            update_bgrnd_shifters(ppu);
+            if (rendering) fetch_bgrnd(ppu, actions);
         }
 
-        if (pre_render_scanline && cycle >= 280 && cycle <= 304) {
-            transfer_addr_y(ppu);
-        }
+        update_sprite_shifters(ppu);
+    }
 
-        if (cycle == 257) {
-            memset(ppu->sprites, 0xFF, 0x08 * sizeof(_sprite));
-            ppu->sprite_count = 0;
-            ppu->sprite_0_hit_possible = 0;
+    if (actions & DOT_INC_Y) {
+        increment_scroll_y(ppu);
+    }
+
+    if (actions & DOT_LOAD_X) {
+        load_bgrnd_shifters(ppu);
+        transfer_addr_x(ppu);
+    }
+
+    if (rendering && (actions & DOT_DUMMY_NT)) {
+        ppu->bgrnd_next_id = ppu_read(ppu, 0x2000 | (ppu->vram_addr & 0x0FFF));
+    }
+
+    if (actions & DOT_LOAD_Y) {
+        transfer_addr_y(ppu);
+    }
 
-            uint16_t next_scanline = (uint16_t)((scanline + 1) % (NES_ALL_HMAX + 1));
+    if (actions & DOT_SPRITE_CLEAR) {
+        memset(ppu->sprites, 0xFF, 0x08 * sizeof(_sprite));
+        ppu->sprite_count = 0;
+        ppu->sprite_0_hit_possible = 0;
 
-            if (rendering && next_scanline <= NES_H && scanline < NES_H) {
-                int16_t eval_scanline = (pre_render_scanline ? 0 : (int16_t)scanline);
-                uint8_t oam_entry = 0;
+        if (rendering && (actions & DOT_SPRITE_EVAL)) {
+            int16_t eval_scanline = (int16_t)scanline;
+            uint8_t oam_entry = 0;
 
-                while (oam_entry < 64 && ppu->sprite_count < 9) {
-                    int16_t offset = eval_scanline - (int16_t)ppu->oam[oam_entry].pos_y;
-                    int16_t max_offset = (ppu->ppuctrl & SPRITE_HEIGHT) ? 16 : 8;
+            while (oam_entry < 64 && ppu->sprite_count < 9) {
+                int16_t offset = eval_scanline - (int16_t)ppu->oam[oam_entry].pos_y;
+                int16_t max_offset = (ppu->ppuctrl & SPRITE_HEIGHT) ? 16 : 8;
 
-                    if (offset >= 0 && offset < max_offset) {
-                        if (ppu->sprite_count < 8) {
-                            if (!oam_entry) {
-                                ppu->sprite_0_hit_possible = 1;
-                            }
-                            ppu->sprites[ppu->sprite_count++] = ppu->oam[oam_entry];
-                        } else {
-                            ppu->ppustatus |= SPRITE_OVERFLOW;
+                if (offset >= 0 && offset < max_offset) {
+                    if (ppu->sprite_count < 8) {
+                        if (!oam_entry) {
+                            ppu->sprite_0_hit_possible = 1;
                         }
+                        ppu->sprites[ppu->sprite_count++] = ppu->oam[oam_entry];
+                    } else {
+                        ppu->ppustatus |= SPRITE_OVERFLOW;
                     }
-
-                    oam_entry++;
                 }
+
+                oam_entry++;
             }
         }
+    }
 
-        if (cycle == NES_ALL_WMAX) {
-            uint16_t next_scanline = (uint16_t)((scanline + 1) % (NES_ALL_HMAX + 1));
-
-            if (next_scanline < NES_H && scanline < NES_H) {
-                for (uint8_t i = 0; i < ppu->sprite_count; i++) {
-                    _sprite* s = &ppu->sprites[i];
+    if (rendering && (actions & DOT_SPRITE_FETCH)) {
+        uint8_t i = (uint8_t)((cycle - 261) >> 3);
+        _sprite* s = &ppu->sprites[i];
 
-                    int16_t line = (int16_t)scanline - (int16_t)s->pos_y;
-                    uint8_t flip_v = (s->attr & FLIP_VERTICAL);
-                    uint8_t flip_h = (s->attr & FLIP_HORIZONTAL);
+        int16_t line = (int16_t)scanline - (int16_t)s->pos_y;
+        uint8_t flip_v = (s->attr & FLIP_VERTICAL);
+        uint8_t flip_h = (s->attr & FLIP_HORIZONTAL);
 
-                    uint16_t addr_low, addr_high;
+        uint16_t addr_low, addr_high;
 
-                    if (ppu->ppuctrl & SPRITE_HEIGHT) {
-                        uint8_t y = (uint8_t)line;
-                        if (flip_v) y = 15 - y;
+        if (ppu->ppuctrl & SPRITE_HEIGHT) {
+            uint8_t y = (uint8_t)line;
+            if (flip_v) y = 15 - y;
 
-                        uint8_t tile = s->id & 0xFE;
-                        if (y >= 8) tile++;
+            uint8_t tile = s->id & 0xFE;
+            if (y >= 8) tile++;
 
-                        uint16_t table = (s->id & 0x01) ? 0x1000 : 0x0000;
-                        addr_low = table | ((uint16_t)tile << 4) | (y & 0x07);
-                    } else {
-                        uint8_t y = (uint8_t)line & 0x07;
-                        if (flip_v) y = 7 - y;
+            uint16_t table = (s->id & 0x01) ? 0x1000 : 0x0000;
+            addr_low = table | ((uint16_t)tile << 4) | (y & 0x07);
+        } else {
+            uint8_t y = (uint8_t)line & 0x07;
+            if (flip_v) y = 7 - y;
 
-                        uint16_t base = (ppu->ppuctrl & SPRITE_SEL) ? 0x1000 : 0x0000;
-                        addr_low = base | ((uint16_t)s->id << 4) | y;
-                    }
+            uint16_t base = (ppu->ppuctrl & SPRITE_SEL) ? 0x1000 : 0x0000;
+            addr_low = base | ((uint16_t)s->id << 4) | y;
+        }
 
-                    addr_high = addr_low + 8;
+        addr_high = addr_low + 8;
 
-                    uint8_t bits_lo = ppu_read(ppu, addr_low);
-                    uint8_t bits_hi = ppu_read(ppu, addr_high);
+        uint8_t bits_lo = ppu_read(ppu, addr_low);
+        uint8_t bits_hi = ppu_read(ppu, addr_high);
 
-                    if (flip_h) {
-                        bits_lo = reverse_byte(bits_lo);
-                        bits_hi = reverse_byte(bits_hi);
-                    }
+        if (flip_h) {
+            bits_lo = reverse_byte(bits_lo);
+            bits_hi = reverse_byte(bits_hi);
+        }
 
-                    ppu->sprite_pattern_low[i] = bits_lo;
-                    ppu->sprite_pattern_high[i] = bits_hi;
-                }
-            }
+        if ((actions & DOT_SPRITE_LOAD) && i < ppu->sprite_count) {
+            ppu->sprite_pattern_low[i] = bits_lo;
+            ppu->sprite_pattern_high[i] = bits_hi;
         }
     }
 
-    uint8_t bgrnd_pixel = 0x00;
-    uint8_t bgrnd_palette = 0x00;
-
-    if (rendering) {
-        uint16_t sel = (uint16_t)(0x8000u >> ppu->fine_x);
-
-        uint8_t pixel_p0 = !!(ppu->bgrnd_pattern_low & sel);
-        uint8_t pixel_p1 = !!(ppu->bgrnd_pattern_high & sel);
-        bgrnd_pixel = (uint8_t)((pixel_p1 << 1) | pixel_p0);
-
-        uint8_t pal0 = !!(ppu->bgrnd_attr_low & sel);
-        uint8_t pal1 = !!(ppu->bgrnd_attr_high & sel);
-        bgrnd_palette = (uint8_t)((pal1 << 1) | pal0);
+    if ((actions & DOT_PIXEL) && cycle == ppu->sprite_0_dot) {
+        ppu->ppustatus |= SPRITE_0_HIT;
+        ppu->sprite_0_dot = 0;
     }
 
-    uint8_t no_left_column = !(ppu->ppumask & BGRND_LC_EN) &&
-                             cycle >= 1 && cycle <= 8;
+    uint8_t sprite_0_test = ppu->sprite_0_scan && ppu->sprite_0_hit_possible &&
+                            !(ppu->ppustatus & SPRITE_0_HIT);
+    uint8_t emit = !ppu->no_output && (!ppu->raster_line || ppu->raster_line->mode == RASTER_DIRECT);
 
-    if (!bgrnd_enabled(ppu) || no_left_column) {
-        bgrnd_pixel = 0;
-    }
+    if ((actions & DOT_PIXEL) && (emit || sprite_0_test)) {
+        uint8_t bgrnd_pixel = 0x00;
+        uint8_t bgrnd_palette = 0x00;
 
-    uint8_t sprite_pixel = 0x00;
-    uint8_t sprite_palette = 0x00;
-    uint8_t sprite_priority = 0x00;
+        if (rendering) {
+            uint8_t* memo_row = ppu->memo_state ? ppu->bgrnd_memo[scanline].row : NULL;
 
-    if (sprite_enabled(ppu)) {
-        ppu->sprite_0_rendered = 0;
+            if (ppu->memo_state == MEMO_REPLAY) {
+                bgrnd_pixel = memo_row[cycle - 1] & 0x03;
+                bgrnd_palette = memo_row[cycle - 1] >> 2;
+            } else {
+                uint16_t sel = (uint16_t)(0x8000u >> ppu->fine_x);
 
-        for (uint8_t i = 0; i < ppu->sprite_count; i++) {
-            if (ppu->sprites[i].pos_x == 0) {
-                uint8_t sp_lo = !!(ppu->sprite_pattern_low[i] & 0x80);
-                uint8_t sp_hi = !!(ppu->sprite_pattern_high[i] & 0x80);
-                sprite_pixel = (uint8_t)((sp_hi << 1) | sp_lo);
+                uint8_t pixel_p0 = !!(ppu->bgrnd_pattern_low & sel);
+                uint8_t pixel_p1 = !!(ppu->bgrnd_pattern_high & sel);
+                bgrnd_pixel = (uint8_t)((pixel_p1 << 1) | pixel_p0);
 
-                sprite_palette = (ppu->sprites[i].attr & SPRITE_PALETTE) + 0x04;
-                sprite_priority = !(ppu->sprites[i].attr & PRIORITY);
+                uint8_t pal0 = !!(ppu->bgrnd_attr_low & sel);
+                uint8_t pal1 = !!(ppu->bgrnd_attr_high & sel);
+                bgrnd_palette = (uint8_t)((pal1 << 1) | pal0);
 
-                if (sprite_pixel) {
-                    if (i == 0) {
-                        ppu->sprite_0_rendered = 1;
-                    }
-                    break;
+                if (memo_row) {
+                    memo_row[cycle - 1] = (uint8_t)((bgrnd_palette << 2) | bgrnd_pixel);
                 }
             }
         }
-    }
 
-    if (!(ppu->ppumask & SPRITE_LC_EN) && cycle >= 1 && cycle <= 8) {
-        sprite_pixel = 0;
-    }
+        uint8_t no_left_column = !(ppu->ppumask & BGRND_LC_EN) &&
+                                 cycle >= 1 && cycle <= 8;
+
+        if (!bgrnd_enabled(ppu) || no_left_column) {
+            bgrnd_pixel = 0;
+        }
 
+        uint8_t sprite_pixel = 0x00;
+        uint8_t sprite_palette = 0x00;
+        uint8_t sprite_priority = 0x00;
 
-    uint8_t pixel = 0x00;
-    uint8_t palette = 0x00;
+        if (sprite_enabled(ppu)) {
+            ppu->sprite_0_rendered = 0;
 
-    if (!bgrnd_pixel && sprite_pixel) {
-        pixel = sprite_pixel;
-        palette = sprite_palette;
-    } else if (bgrnd_pixel && !sprite_pixel) {
-        pixel = bgrnd_pixel;
-        palette = bgrnd_palette;
-    } else if (bgrnd_pixel && sprite_pixel) {
-        uint8_t will_sprite_0_hit = ppu->sprite_0_hit_possible && ppu->sprite_0_rendered;
-        uint8_t rendering_both = bgrnd_enabled(ppu) && sprite_enabled(ppu);
+            for (uint8_t i = 0; i < ppu->sprite_count; i++) {
+                if (ppu->sprites[i].pos_x == 0) {
+                    uint8_t sp_lo = !!(ppu->sprite_pattern_low[i] & 0x80);
+                    uint8_t sp_hi = !!(ppu->sprite_pattern_high[i] & 0x80);
+                    sprite_pixel = (uint8_t)((sp_hi << 1) | sp_lo);
 
-        uint8_t bg_clip_disabled = !(ppu->ppumask & BGRND_LC_EN);
-        uint8_t sprite_clip_disabled = !(ppu->ppumask & SPRITE_LC_EN);
-        uint8_t left_clip_active = bg_clip_disabled || sprite_clip_disabled;
-        uint8_t min_x_pos = left_clip_active ? 9 : 1;
+                    sprite_palette = (ppu->sprites[i].attr & SPRITE_PALETTE) + 0x04;
+                    sprite_priority = !(ppu->sprites[i].attr & PRIORITY);
 
-        uint8_t in_range =
-            (cycle >= min_x_pos) &&
-            (cycle < 256) &&
-            (scanline < NES_H);
+                    if (sprite_pixel) {
+                        if (i == 0) {
+                            ppu->sprite_0_rendered = 1;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
 
-        if (will_sprite_0_hit && rendering_both && in_range) {
-            ppu->ppustatus |= SPRITE_0_HIT;
+        if (!(ppu->ppumask & SPRITE_LC_EN) && cycle >= 1 && cycle <= 8) {
+            sprite_pixel = 0;
         }
 
-        if (sprite_priority) {
+
+        uint8_t pixel = 0x00;
+        uint8_t palette = 0x00;
+
+        if (!bgrnd_pixel && sprite_pixel) {
             pixel = sprite_pixel;
             palette = sprite_palette;
-        } else {
+        } else if (bgrnd_pixel && !sprite_pixel) {
             pixel = bgrnd_pixel;
             palette = bgrnd_palette;
+        } else if (bgrnd_pixel && sprite_pixel) {
+            uint8_t will_sprite_0_hit = ppu->sprite_0_hit_possible && ppu->sprite_0_rendered;
+            uint8_t rendering_both = bgrnd_enabled(ppu) && sprite_enabled(ppu);
+
+            uint8_t bg_clip_disabled = !(ppu->ppumask & BGRND_LC_EN);
+            uint8_t sprite_clip_disabled = !(ppu->ppumask & SPRITE_LC_EN);
+            uint8_t left_clip_active = bg_clip_disabled || sprite_clip_disabled;
+            uint8_t min_x_pos = left_clip_active ? 9 : 1;
+
+            uint8_t in_range =
+                (cycle >= min_x_pos) &&
+                (cycle < 256) &&
+                (scanline < NES_H);
+
+            if (will_sprite_0_hit && rendering_both && in_range) {
+                ppu->ppustatus |= SPRITE_0_HIT;
+            }
+
+            if (sprite_priority) {
+                pixel = sprite_pixel;
+                palette = sprite_palette;
+            } else {
+                pixel = bgrnd_pixel;
+                palette = bgrnd_palette;
+            }
         }
-    }
 
-    if (visible_scanline && cycle >= 1 && cycle <= NES_W) {
-        uint8_t x = (uint8_t)(cycle - 1);
-        uint8_t y = (uint8_t)scanline;
+        if (emit) {
+            uint8_t x = (uint8_t)(cycle - 1);
+            uint8_t y = (uint8_t)scanline;
 
-        uint32_t color = get_color(
-            ppu, palette,
-            (ppu->ppumask & EMPHASIS) >> 5,
-            pixel
-        );
+            uint32_t color = get_color(ppu, palette, pixel);
 
-        set_pixel(ppu, x, y, color);
+            set_pixel(ppu, x, y, color);
+        }
+    }
+
+    if (actions & DOT_MEMO_END) {
+        bgrnd_memo_end(ppu);
+    }
+
+    if (actions & DOT_RASTER_COMMIT) {
+        ppu_raster_commit(ppu);
     }
 
     ppu->cycle++;
+    ppu->dots++;
 
-    if (pre_render_scanline && cycle == 339 &&
-        render_enabled(ppu) && ppu->odd_frame) {
+    if ((actions & DOT_ODD_SKIP) && render_enabled(ppu) && ppu->odd_frame) {
         ppu->cycle = NES_ALL_WMAX + 1;
+        // a frame moves the colour burst a third, the skipped dot moves it one more
+        ppu->burst_phase++;
     }
 
     if (ppu->cycle > NES_ALL_WMAX) {
@@ -346,41 +352,265 @@ CNES_RESULT ppu_clock(_ppu* ppu) {
         if (++ppu->scanline > NES_ALL_HMAX) {
             ppu->scanline = 0;
             ppu->odd_frame = !ppu->odd_frame;
+            ppu->burst_phase = (ppu->burst_phase + 1) % NES_BURST_PHASES;
         }
     }
 
     return frame_complete;
 }
 
+uint32_t ppu_idle_span(_ppu* ppu) {
+    const uint32_t line_dots = NES_ALL_WMAX + 1;
+    const uint32_t frame_dots = line_dots * (NES_ALL_HMAX + 1);
+    const uint32_t vbl_set = 241 * line_dots + 1;
+    const uint32_t vbl_clear = NES_ALL_HMAX * line_dots + 1;
+
+    if (ppu->nmi_delay || ppu->suppress_vbl_flag) return 0;
+
+    uint32_t pos = ppu->scanline * line_dots + ppu->cycle;
+    if (pos == vbl_set || pos == vbl_clear) return 0;
+
+    uint32_t end;
+
+    if (render_enabled(ppu)) {
+        if (pos < NES_H * line_dots || pos > vbl_clear) return 0;
+        end = (pos < vbl_set) ? vbl_set : vbl_clear;
+    } else {
+        if (pos < vbl_set) end = vbl_set;
+        else if (pos < vbl_clear) end = vbl_clear;
+        else end = vbl_set + frame_dots;
+    }
+
+    return end - pos;
+}
+
+void ppu_sync(_ppu* ppu) {
+    uint32_t dots = ppu->dot_debt;
+    if (!dots) return;
+    ppu->dot_debt = 0;
+    ppu->dots += dots;
+
+    if (ppu->bus_decay) {
+        if (ppu->bus_decay > dots) {
+            ppu->bus_decay -= dots;
+        } else {
+            ppu->bus_decay = 0;
+            ppu->ppudata = 0;
+        }
+    }
+
+    while (dots) {
+        uint16_t start = ppu->cycle;
+        uint16_t span = NES_ALL_WMAX + 1 - start;
+        if (span > dots) span = dots;
+        uint16_t end = start + span;
+
+        uint8_t visible_scanline = ppu->scanline < NES_H;
+
+        if (visible_scanline && start <= 1 && end > 1) {
+            sprite_0_begin(ppu);
+        }
+
+        if (visible_scanline && !ppu->no_output) {
+            if (ppu->raster && start <= 1 && end > 1) {
+                ppu_raster_begin(ppu);
+            }
+
+            uint16_t x0 = start ? start - 1 : 0;
+            uint16_t x1 = end > NES_W + 1 ? NES_W : end - 1;
+            uint32_t color = get_color(ppu, 0, 0);
+
+            if (!ppu->raster_line) {
+                fill_pixels(ppu->pixels + ppu->scanline * ppu->pitch, x0, x1, color, ppu->pixel_size);
+            } else if (ppu->raster_line->mode == RASTER_DIRECT) {
+                fill_pixels((uint8_t*)ppu->raster_line->pixels, x0, x1, color, 4);
+            }
+
+            if (ppu->raster_line && start <= 257 && end > 257) {
+                ppu_raster_commit(ppu);
+            }
+        }
+
+        if ((visible_scanline || ppu->scanline == NES_ALL_HMAX) && start <= 257 && end > 257) {
+            memset(ppu->sprites, 0xFF, 0x08 * sizeof(_sprite));
+            ppu->sprite_count = 0;
+            ppu->sprite_0_hit_possible = 0;
+        }
+
+        dots -= span;
+        ppu->cycle = end;
+
+        if (ppu->cycle > NES_ALL_WMAX) {
+            ppu->cycle = 0;
+
+            if (++ppu->scanline > NES_ALL_HMAX) {
+                ppu->scanline = 0;
+                ppu->odd_frame = !ppu->odd_frame;
+                ppu->burst_phase = (ppu->burst_phase + 1) % NES_BURST_PHASES;
+            }
+        }
+    }
+}
+
 void set_pixel(_ppu* ppu, uint16_t x, uint16_t y, uint32_t color) {
     if (!ppu || !ppu->pixels) return;
     if (x >= NES_W || y >= NES_H) return;
-    ppu->pixels[y * NES_W + x] = color;
+
+    if (ppu->raster_line) ppu->raster_line->pixels[x] = color;
+    else fill_pixels(ppu->pixels + y * ppu->pitch, x, x + 1, color, ppu->pixel_size);
 }
 
 CNES_RESULT ppu_init(_ppu* ppu) {
-    ppu->pixels = (uint32_t*)SDL_calloc(NES_PIXELS, sizeof(uint32_t));
-    if (!ppu->pixels) {
+    ppu->own_pixels = (uint8_t*)SDL_calloc(NES_PIXELS, sizeof(uint32_t));
+    if (!ppu->own_pixels) {
         fprintf(stderr, "[ERROR] Failed to allocate pixel buffer!\n");
         return CNES_FAILURE;
     }
 
+    ppu->pixels = ppu->own_pixels;
+    ppu->pitch = NES_W * sizeof(uint32_t);
+    ppu->format = PIXEL_RGBA8888;
+    ppu->pixel_size = pixel_size(PIXEL_RGBA8888);
+
+    ppu->bgrnd_memo = (_bgrnd_memo*)SDL_calloc(NES_H, sizeof(_bgrnd_memo));
+    if (!ppu->bgrnd_memo) {
+        fprintf(stderr, "[ERROR] Failed to allocate background memo!\n");
+        return CNES_FAILURE;
+    }
+
+    if (SDL_GetNumLogicalCPUCores() > 1) {
+        ppu->raster = (_raster*)SDL_calloc(1, sizeof(_raster));
+
+        if (ppu->raster &&
+            raster_init(ppu->raster, ppu->pixels, ppu->pitch, ppu->pixel_size) != CNES_SUCCESS) {
+            fprintf(stderr, "[ERROR] Failed to start raster thread, rendering inline!\n");
+            SDL_free(ppu->raster);
+            ppu->raster = NULL;
+        }
+    }
+
+    update_palette_cache(ppu);
+    ppu_build_dot_table();
+
+    return CNES_SUCCESS;
+}
+
+void ppu_deinit(_ppu* ppu) {
+    if (ppu->raster) {
+        raster_deinit(ppu->raster);
+        SDL_free(ppu->raster);
+    }
+
+    SDL_free(ppu->own_pixels);
+    SDL_free(ppu->bgrnd_memo);
+    ppu->pixels = NULL;
+    ppu->own_pixels = NULL;
+    ppu->bgrnd_memo = NULL;
+    ppu->raster = NULL;
+    ppu->raster_line = NULL;
+}
+
+CNES_RESULT ppu_set_target(_ppu* ppu, void* pixels, size_t pitch, _pixel_format format) {
+    if (format >= PIXEL_FORMATS) {
+        fprintf(stderr, "[ERROR] Unknown pixel format %d!\n", (int)format);
+        return CNES_FAILURE;
+    }
+
+    uint8_t size = pixel_size(format);
+
+    if (!pixels) {
+        pixels = ppu->own_pixels;
+        pitch = NES_W * size;
+    }
+
+    if (pitch < NES_W * size || (((uintptr_t)pixels | pitch) & (size - 1))) {
+        fprintf(stderr, "[ERROR] Render target pitch or alignment does not fit the pixel format!\n");
+        return CNES_FAILURE;
+    }
+
+    ppu_raster_wait(ppu);
+
+    ppu->pixels = (uint8_t*)pixels;
+    ppu->pitch = pitch;
+    ppu->format = format;
+    ppu->pixel_size = size;
+
+    if (ppu->raster) {
+        ppu->raster->target = ppu->pixels;
+        ppu->raster->pitch = pitch;
+        ppu->raster->pixel_size = size;
+    }
+
+    update_palette_cache(ppu);
+
     return CNES_SUCCESS;
 }
 
+void ppu_build_dot_table(void) {
+    for (uint16_t scanline = 0; scanline <= NES_ALL_HMAX; scanline++) {
+        if (scanline < NES_H - 1)           line_type[scanline] = LINE_VISIBLE;
+        else if (scanline == NES_H - 1)     line_type[scanline] = LINE_VISIBLE_LAST;
+        else if (scanline == NES_H)         line_type[scanline] = LINE_POST_RENDER;
+        else if (scanline == 241)           line_type[scanline] = LINE_VBLANK_START;
+        else if (scanline < NES_ALL_HMAX)   line_type[scanline] = LINE_VBLANK;
+        else                                line_type[scanline] = LINE_PRE_RENDER;
+    }
+
+    for (uint8_t type = 0; type < LINE_TYPES; type++) {
+        uint8_t visible = (type == LINE_VISIBLE || type == LINE_VISIBLE_LAST);
+        uint8_t pre_render = (type == LINE_PRE_RENDER);
+
+        for (uint16_t cycle = 0; cycle <= NES_ALL_WMAX; cycle++) {
+            uint32_t actions = 0;
+
+            if (visible || pre_render) {
+                uint8_t in_visible_fetch_range = (cycle >= 2 && cycle <= 257);
+                uint8_t in_blank_fetch_range = (cycle >= 321 && cycle <= 337);
+
+                if (in_visible_fetch_range || in_blank_fetch_range) {
+                    static const uint32_t stage_actions[8] = {
+                        DOT_FETCH_NT, 0, DOT_FETCH_AT, 0,
+                        DOT_FETCH_LO, 0, DOT_FETCH_HI, DOT_INC_X
+                    };
+
+                    actions |= DOT_SHIFT | stage_actions[(cycle - 1) & 0x07];
+                }
+
+                if (cycle == NES_W) actions |= DOT_INC_Y;
+                if (cycle == NES_W + 1) actions |= DOT_LOAD_X | DOT_SPRITE_CLEAR;
+                if (cycle >= 261 && cycle <= 317 && ((cycle - 261) & 0x07) == 0) actions |= DOT_SPRITE_FETCH;
+                if (cycle == 338 || cycle == 340) actions |= DOT_DUMMY_NT;
+                if (pre_render && cycle >= 280 && cycle <= 304) actions |= DOT_LOAD_Y;
+                if (visible && cycle == NES_W + 1) actions |= DOT_SPRITE_EVAL;
+                if (type == LINE_VISIBLE) actions |= DOT_SPRITE_LOAD;
+                if (visible && cycle >= 1 && cycle <= NES_W) actions |= DOT_PIXEL;
+                if (visible && cycle == 1) actions |= DOT_MEMO_BEGIN;
+                if (visible && cycle == NES_W - 1) actions |= DOT_MEMO_END;
+                if (visible && cycle == 1) actions |= DOT_RASTER_BEGIN;
+                if (visible && cycle == NES_W + 1) actions |= DOT_RASTER_COMMIT;
+                if (visible && cycle == 1) actions |= DOT_SPRITE_0;
+            }
+
+            if (type == LINE_VBLANK_START && cycle == 1) actions |= DOT_VBL_SET;
+            if (type == LINE_VBLANK_START && cycle > 1) actions |= DOT_VBL_LATE;
+            if (pre_render && cycle == 1) actions |= DOT_VBL_CLEAR;
+            if (pre_render && cycle == 339) actions |= DOT_ODD_SKIP;
+
+            dot_actions[type][cycle] = actions;
+        }
+    }
+}
+
 uint8_t ppu_read(_ppu* ppu, uint16_t addr) {
     uint8_t data = 0x00;
     addr &= 0x3FFF;
 
+    if (ppu->p_cart->mapper.a12_rise) ppu_watch_a12(ppu, addr);
+
     if (0x0000 <= addr && addr <= 0x1FFF) {
         data = cart_ppu_read(ppu->p_cart, addr);
     } else if (0x2000 <= addr && addr <= 0x3EFF) {
-        uint16_t index = (addr - 0x2000) & 0x0FFF;
-        uint8_t logic_nt = index >> 10;
-        uint16_t offset = index & 0x03FF;
-
-        uint8_t physical_nt = physical_nametable(ppu->p_cart, logic_nt);
-        data = ppu->nametable[(physical_nt << 10) | offset];
+        data = ppu->p_cart->ntbl[(addr >> 10) & 0x03][addr & 0x03FF];
 
     } else if (0x3F00 <= addr && addr <= 0x3FFF) {
         uint8_t backdrop = (addr & 0x03) == 0x00;
@@ -394,28 +624,42 @@ uint8_t ppu_read(_ppu* ppu, uint16_t addr) {
 void ppu_write(_ppu* ppu, uint16_t addr, uint8_t data) {
     addr &= 0x3FFF;
 
+    if (ppu->p_cart->mapper.a12_rise) ppu_watch_a12(ppu, addr);
+
     if (0x0000 <= addr && addr <= 0x1FFF) {
         cart_ppu_write(ppu->p_cart, addr, data);
+        ppu->p_cart->chr_gen++;
     } else if (0x2000 <= addr && addr <= 0x3EFF) {
-        uint16_t index = (addr - 0x2000) & 0x0FFF;
-        uint8_t logic_nt = index >> 10;
-        uint16_t offset = index & 0x03FF;
-
-        uint8_t phys_nt = physical_nametable(ppu->p_cart, logic_nt);
-        ppu->nametable[(phys_nt << 10) | offset] = data;
+        uint8_t* page = ppu->p_cart->ntbl[(addr >> 10) & 0x03];
+        page[addr & 0x03FF] = data;
+        bgrnd_memo_invalidate(ppu, page, addr & 0x03FF);
 
     } else if (0x3F00 <= addr && addr <= 0x3FFF) {
+        ppu_raster_break(ppu);
+
         uint8_t backdrop = (addr & 0x03) == 0x00;
-        if (backdrop) ppu->palette_idx[addr & 0x0F] = data;
-        else ppu->palette_idx[addr & 0x1F] = data;
+        if (backdrop) {
+            ppu->palette_idx[addr & 0x0F] = data;
+            update_palette_entry(ppu, addr & 0x0F);
+            update_palette_entry(ppu, (addr & 0x0F) | 0x10);
+        } else {
+            ppu->palette_idx[addr & 0x1F] = data;
+            update_palette_entry(ppu, addr & 0x1F);
+        }
     }
 }
 
 
 uint8_t ppu_cpu_read(_ppu* ppu, uint16_t addr) {
+    ppu_sync(ppu);
+
     uint8_t data = 0x00;
     uint16_t reg_addr = 0x2000 | (addr & 0x0007);
 
+    if (reg_addr == PPUDATA) {
+        ppu_bgrnd_memo_break(ppu);
+    }
+
     switch (reg_addr) {
         case PPUSTATUS: data = ppustatus_cpu_read(ppu); break;
         case OAMDATA:   data = oamdata_cpu_read(ppu);   break;
@@ -423,10 +667,14 @@ uint8_t ppu_cpu_read(_ppu* ppu, uint16_t addr) {
         default:        data = ppu->ppudata;            break;
     }
 
+    ppu->idle_dots = ppu_idle_span(ppu);
+
     return data;
 }
 
 void ppu_cpu_write(_ppu* ppu, uint16_t addr, uint8_t data) {
+    ppu_sync(ppu);
+    ppu_bgrnd_memo_break(ppu);
     ppu_bus_set(ppu, data);
     uint16_t reg_addr = 0x2000 | (addr & 0x0007);
 
@@ -441,6 +689,8 @@ void ppu_cpu_write(_ppu* ppu, uint16_t addr, uint8_t data) {
         case OAMDMA:    oamdma_cpu_write(ppu, data);    break;
         default: return;
     }
+
+    ppu->idle_dots = ppu_idle_span(ppu);
 }
 
 uint8_t ppustatus_cpu_read(_ppu* ppu) {
@@ -513,7 +763,16 @@ void ppuctrl_cpu_write(_ppu* ppu, uint8_t data) {
 }
 
 void ppumask_cpu_write(_ppu* ppu, uint8_t data) {
+    uint8_t changed = ppu->ppumask ^ data;
+    if (changed) {
+        ppu_raster_break(ppu);
+        sprite_0_invalidate(ppu);
+    }
     ppu->ppumask = data;
+
+    if (changed & (EMPHASIS | GREYSCALE)) {
+        update_palette_cache(ppu);
+    }
 }
 
 void oamaddr_cpu_write(_ppu* ppu, uint8_t data) {
@@ -526,6 +785,10 @@ void oamdata_cpu_write(_ppu* ppu, uint8_t data) {
 
 void ppuscroll_cpu_write(_ppu* ppu, uint8_t data) {
     if (!ppu->write_toggle) {
+        if ((data & 0x07) != ppu->fine_x) {
+            ppu_raster_break(ppu);
+            sprite_0_invalidate(ppu);
+        }
         ppu->fine_x = data & 0x07;
         ppu->tram_addr = (ppu->tram_addr & ~COARSE_X) | ((data >> 3) & COARSE_X);
         ppu->write_toggle = 1;
@@ -560,17 +823,6 @@ void oamdma_cpu_write(_ppu* ppu, uint8_t data) {
     ppu->dma.dummy_cycle = 1;
 }
 
-uint8_t physical_nametable(_cart* cart, uint8_t logical) {
-    switch (cart->mirror) {
-        case MIRROR_HORIZONTAL: return (logical >> 1) & 1;
-        case MIRROR_VERTICAL:   return logical & 1;
-        case MIRROR_SINGLE0:    return 0;
-        case MIRROR_SINGLE1:    return 1;
-        case MIRROR_FOUR:       return logical & 3;
-        default: return 0;
-    }
-}
-
 void increment_scroll_x(_ppu* ppu) {
     if (!render_enabled(ppu)) return;
 
@@ -630,14 +882,64 @@ void load_bgrnd_shifters(_ppu* ppu) {
     ppu->bgrnd_attr_high = (ppu->bgrnd_attr_high & 0xFF00) | next_attr_high;
 }
 
-void update_shifters(_ppu* ppu) {
+void fetch_bgrnd(_ppu* ppu, uint32_t actions) {
+    if (actions & DOT_FETCH_NT) {
+        if (ppu->raster_line && ppu->cycle >= 9) {
+            uint8_t tile = (uint8_t)((ppu->cycle - 9) >> 3);
+            ppu->raster_line->tile_low[tile] = ppu->bgrnd_next_low;
+            ppu->raster_line->tile_high[tile] = ppu->bgrnd_next_high;
+            ppu->raster_line->tile_attr[tile] = ppu->bgrnd_next_attr;
+        }
+
+        load_bgrnd_shifters(ppu);
+
+        if (ppu->sprite_0_predict && ppu->memo_state != MEMO_REPLAY && ppu->cycle <= NES_W) {
+            sprite_0_predict(ppu, 8 - ppu->fine_x);
+        }
+
+        ppu->bgrnd_next_id = ppu_read(ppu, 0x2000 | (ppu->vram_addr & 0x0FFF));
+    } else if (actions & DOT_FETCH_AT) {
+        uint16_t v = ppu->vram_addr;
+        ppu->bgrnd_next_attr = ppu_read(
+            ppu,
+            0x23C0 |
+            (v & (NTBL_Y | NTBL_X)) |
+            ((v >> 4) & 0x38) |
+            ((v >> 2) & 0x07)
+        );
+
+        if (v & 0x0040) ppu->bgrnd_next_attr >>= 4;
+        if (v & 0x0002) ppu->bgrnd_next_attr >>= 2;
+        ppu->bgrnd_next_attr &= 0x03;
+    } else if (actions & DOT_FETCH_LO) {
+        ppu->bgrnd_next_low = ppu_read(
+            ppu,
+            ((uint16_t)(ppu->ppuctrl & BGRND_SEL) << 8) |
+            ((uint16_t)ppu->bgrnd_next_id << 4) |
+            ((ppu->vram_addr & FINE_Y) >> 12)
+        );
+    } else if (actions & DOT_FETCH_HI) {
+        ppu->bgrnd_next_high = ppu_read(
+            ppu,
+            (((uint16_t)(ppu->ppuctrl & BGRND_SEL) << 8) |
+            ((uint16_t)ppu->bgrnd_next_id << 4) |
+            ((ppu->vram_addr & FINE_Y) >> 12)) + 8
+        );
+    } else if (actions & DOT_INC_X) {
+        increment_scroll_x(ppu);
+    }
+}
+
+void update_bgrnd_shifters(_ppu* ppu) {
     if (render_enabled(ppu)) {
         ppu->bgrnd_pattern_low <<= 1;
         ppu->bgrnd_pattern_high <<= 1;
         ppu->bgrnd_attr_low <<= 1;
         ppu->bgrnd_attr_high <<= 1;
     }
+}
 
+void update_sprite_shifters(_ppu* ppu) {
     uint8_t sprite_visible = ppu->cycle >= 1 && ppu->cycle <= (NES_W + 1);
     if (render_enabled(ppu) && sprite_visible) {
         for (uint8_t i = 0; i < ppu->sprite_count; i++) {
@@ -671,6 +973,278 @@ void ppu_update_nmi_state(_ppu* ppu) {
     ppu->nmi_previous = nmi_now;
 }
 
-uint32_t get_color(_ppu* ppu, uint8_t palette, uint8_t emphasis, uint8_t pixel) {
-    return nes_pal[emphasis & 0x07][ppu_read(ppu, 0x3F00 + (palette << 2) + pixel) & 0x3F];
+static inline uint8_t sprite_0_covers(_ppu* ppu, uint16_t dot) {
+    if (dot < ppu->sprite_0_min_dot || dot >= NES_W) return 0;
+
+    uint16_t x = dot - 1;
+    if (x < ppu->sprite_0_x || x > ppu->sprite_0_x + 7) return 0;
+
+    return (ppu->sprite_0_bits >> (7 - (x - ppu->sprite_0_x))) & 0x01;
+}
+
+void sprite_0_begin(_ppu* ppu) {
+    ppu->sprite_0_predict = 0;
+    ppu->sprite_0_scan = 0;
+    ppu->sprite_0_dot = 0;
+
+    uint8_t rendering_both = bgrnd_enabled(ppu) && sprite_enabled(ppu);
+    if (!ppu->sprite_0_hit_possible || !rendering_both || (ppu->ppustatus & SPRITE_0_HIT)) return;
+
+    uint8_t left_clip = !(ppu->ppumask & BGRND_LC_EN) || !(ppu->ppumask & SPRITE_LC_EN);
+    ppu->sprite_0_min_dot = left_clip ? 9 : 1;
+    ppu->sprite_0_x = ppu->sprites[0].pos_x;
+    ppu->sprite_0_bits = ppu->sprite_pattern_low[0] | ppu->sprite_pattern_high[0];
+
+    if (ppu->memo_state == MEMO_REPLAY) {
+        const uint8_t* row = ppu->bgrnd_memo[ppu->scanline].row;
+
+        for (uint16_t dot = 1; dot < NES_W; dot++) {
+            if ((row[dot - 1] & 0x03) && sprite_0_covers(ppu, dot)) {
+                ppu->sprite_0_dot = dot;
+                break;
+            }
+        }
+        return;
+    }
+
+    ppu->sprite_0_predict = 1;
+    sprite_0_predict(ppu, 0);
+}
+
+void sprite_0_predict(_ppu* ppu, uint8_t first) {
+    uint16_t opaque = ppu->bgrnd_pattern_low | ppu->bgrnd_pattern_high;
+    uint8_t last = 15 - ppu->fine_x;
+
+    for (uint8_t i = first; i <= last; i++) {
+        uint16_t dot = ppu->cycle + i;
+
+        if (((opaque >> (last - i)) & 0x01) && sprite_0_covers(ppu, dot)) {
+            ppu->sprite_0_dot = dot;
+            ppu->sprite_0_predict = 0;
+            return;
+        }
+    }
+}
+
+void sprite_0_invalidate(_ppu* ppu) {
+    ppu->sprite_0_predict = 0;
+    ppu->sprite_0_dot = 0;
+    ppu->sprite_0_scan = 1;
+}
+
+uint32_t get_color(_ppu* ppu, uint8_t palette, uint8_t pixel) {
+    return ppu->palette_px[(palette << 2) | pixel];
+}
+
+uint32_t pixel_convert(uint8_t format, uint32_t rgba, uint16_t index) {
+    uint32_t r = rgba & 0xFF;
+    uint32_t g = (rgba >> 8) & 0xFF;
+    uint32_t b = (rgba >> 16) & 0xFF;
+
+    switch (format) {
+    case PIXEL_BGRA8888:
+        return (rgba & 0xFF00FF00) | (r << 16) | b;
+    case PIXEL_RGB565:
+        return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    case PIXEL_INDEX8:
+        return index & 0x3F;
+    case PIXEL_INDEX16:
+        return index;
+    case PIXEL_GRAY8:
+        return (r * 77 + g * 150 + b * 29) >> 8;
+    default:
+        return rgba;
+    }
+}
+
+void update_palette_entry(_ppu* ppu, uint8_t index) {
+    uint8_t emphasis = (ppu->ppumask & EMPHASIS) >> 5;
+    uint8_t mask = (ppu->ppumask & GREYSCALE) ? 0x30 : 0x3F;
+
+    uint8_t backdrop = (index & 0x03) == 0x00;
+    uint8_t entry = backdrop ? ppu->palette_idx[index & 0x0F] : ppu->palette_idx[index];
+
+    ppu->palette_rgba[index] = nes_pal[emphasis][entry & mask];
+    ppu->palette_px[index] = pixel_convert(ppu->format, ppu->palette_rgba[index],
+                                           (uint16_t)((entry & mask) | (emphasis << 6)));
+}
+
+void update_palette_cache(_ppu* ppu) {
+    for (uint8_t i = 0; i < 0x20; i++) {
+        update_palette_entry(ppu, i);
+    }
+}
+
+static inline void bgrnd_state_save(_ppu* ppu, _bgrnd_state* state) {
+    memset(state, 0, sizeof(_bgrnd_state));
+    state->vram_addr = ppu->vram_addr;
+    state->pattern_low = ppu->bgrnd_pattern_low;
+    state->pattern_high = ppu->bgrnd_pattern_high;
+    state->attr_low = ppu->bgrnd_attr_low;
+    state->attr_high = ppu->bgrnd_attr_high;
+    state->next_id = ppu->bgrnd_next_id;
+    state->next_attr = ppu->bgrnd_next_attr;
+    state->next_low = ppu->bgrnd_next_low;
+    state->next_high = ppu->bgrnd_next_high;
+}
+
+static inline void bgrnd_state_load(_ppu* ppu, const _bgrnd_state* state) {
+    ppu->vram_addr = state->vram_addr;
+    ppu->bgrnd_pattern_low = state->pattern_low;
+    ppu->bgrnd_pattern_high = state->pattern_high;
+    ppu->bgrnd_attr_low = state->attr_low;
+    ppu->bgrnd_attr_high = state->attr_high;
+    ppu->bgrnd_next_id = state->next_id;
+    ppu->bgrnd_next_attr = state->next_attr;
+    ppu->bgrnd_next_low = state->next_low;
+    ppu->bgrnd_next_high = state->next_high;
+}
+
+void bgrnd_memo_begin(_ppu* ppu) {
+    _cart* cart = ppu->p_cart;
+    ppu->memo_state = MEMO_OFF;
+
+    if (!ppu->bgrnd_memo || !render_enabled(ppu)) return;
+    if (cart->ppu_snoop || cart->mapper.a12_rise) return;
+
+    _bgrnd_key key;
+    memset(&key, 0, sizeof(_bgrnd_key));
+
+    uint8_t nt = (ppu->vram_addr >> 10) & 0x03;
+    key.ntbl[0] = cart->ntbl[nt];
+    key.ntbl[1] = cart->ntbl[nt ^ 0x01];
+    key.chr_gen = cart->chr_gen;
+    bgrnd_state_save(ppu, &key.start);
+    key.fine_x = ppu->fine_x;
+    key.ppuctrl = ppu->ppuctrl & BGRND_SEL;
+    key.ppumask = ppu->ppumask & (BGRND_EN | SPRITE_EN);
+
+    _bgrnd_memo* memo = &ppu->bgrnd_memo[ppu->scanline];
+    uint8_t need_tiles = ppu->raster && !ppu->no_output;
+
+    if (memo->valid && (memo->tiles || !need_tiles) && !memcmp(&memo->key, &key, sizeof(_bgrnd_key))) {
+        ppu->memo_state = MEMO_REPLAY;
+    } else if (!ppu->no_output) {
+        memcpy(&memo->key, &key, sizeof(_bgrnd_key));
+        memo->valid = 0;
+        ppu->memo_state = MEMO_RECORD;
+    }
+}
+
+void bgrnd_memo_end(_ppu* ppu) {
+    _bgrnd_memo* memo = &ppu->bgrnd_memo[ppu->scanline];
+
+    _raster_line* line = ppu->raster_line;
+
+    // the raster worker composes from the tile fetches, so they are memoized along with the row
+    if (ppu->memo_state == MEMO_REPLAY) {
+        bgrnd_state_load(ppu, &memo->end);
+
+        if (line) {
+            memcpy(line->tile_low, memo->tile_low, sizeof(memo->tile_low));
+            memcpy(line->tile_high, memo->tile_high, sizeof(memo->tile_high));
+            memcpy(line->tile_attr, memo->tile_attr, sizeof(memo->tile_attr));
+        }
+    } else if (ppu->memo_state == MEMO_RECORD) {
+        bgrnd_state_save(ppu, &memo->end);
+        memo->valid = 1;
+        memo->tiles = line != NULL;
+
+        if (line) {
+            memcpy(memo->tile_low, line->tile_low, sizeof(memo->tile_low));
+            memcpy(memo->tile_high, line->tile_high, sizeof(memo->tile_high));
+            memcpy(memo->tile_attr, line->tile_attr, sizeof(memo->tile_attr));
+        }
+    }
+
+    ppu->memo_state = MEMO_OFF;
+}
+
+void bgrnd_memo_invalidate(_ppu* ppu, uint8_t* page, uint16_t offset) {
+    if (!ppu->bgrnd_memo) return;
+
+    uint8_t tile_row = (uint8_t)(offset >> 5);
+    uint8_t attr_row = (offset >= 0x03C0) ? (uint8_t)((offset >> 3) & 0x07) : 0xFF;
+
+    for (uint16_t line = 0; line < NES_H; line++) {
+        _bgrnd_memo* memo = &ppu->bgrnd_memo[line];
+        if (!memo->valid) continue;
+        if (memo->key.ntbl[0] != page && memo->key.ntbl[1] != page) continue;
+
+        uint8_t coarse_y = (memo->key.start.vram_addr & COARSE_Y) >> 5;
+        if (coarse_y == tile_row || (coarse_y >> 2) == attr_row) {
+            memo->valid = 0;
+        }
+    }
+}
+
+void ppu_bgrnd_memo_break(_ppu* ppu) {
+    if (ppu->memo_state == MEMO_REPLAY) {
+        sprite_0_invalidate(ppu);
+
+        uint16_t now = ppu->cycle;
+
+        // fetch_bgrnd files the raster tiles by dot, so step the cycle along with it
+        for (uint16_t cycle = 2; cycle < now && cycle < NES_W; cycle++) {
+            ppu->cycle = cycle;
+            update_bgrnd_shifters(ppu);
+            fetch_bgrnd(ppu, dot_actions[LINE_VISIBLE][cycle]);
+        }
+
+        ppu->cycle = now;
+    } else if (ppu->memo_state == MEMO_RECORD) {
+        ppu->bgrnd_memo[ppu->scanline].valid = 0;
+    }
+
+    ppu->memo_state = MEMO_OFF;
+}
+
+void ppu_raster_begin(_ppu* ppu) {
+    if (!ppu->raster || ppu->no_output) return;
+
+    _raster_line* line = &ppu->raster->lines[ppu->scanline];
+
+    line->mode = RASTER_COMPOSE;
+    line->fine_x = ppu->fine_x;
+    line->ppumask = ppu->ppumask;
+
+    line->shift_low = ppu->bgrnd_pattern_low;
+    line->shift_high = ppu->bgrnd_pattern_high;
+    line->shift_attr_low = ppu->bgrnd_attr_low;
+    line->shift_attr_high = ppu->bgrnd_attr_high;
+
+    line->sprite_count = ppu->sprite_count;
+    for (uint8_t i = 0; i < ppu->sprite_count; i++) {
+        line->sprite_x[i] = ppu->sprites[i].pos_x;
+        line->sprite_attr[i] = ppu->sprites[i].attr;
+        line->sprite_low[i] = ppu->sprite_pattern_low[i];
+        line->sprite_high[i] = ppu->sprite_pattern_high[i];
+    }
+
+    memcpy(line->palette, ppu->palette_px, sizeof(line->palette));
+    ppu->raster_line = line;
+}
+
+void ppu_raster_commit(_ppu* ppu) {
+    if (!ppu->raster_line) return;
+
+    ppu->raster_line = NULL;
+    raster_commit(ppu->raster, ppu->scanline);
+}
+
+void ppu_raster_break(_ppu* ppu) {
+    _raster_line* line = ppu->raster_line;
+    if (!line || line->mode == RASTER_DIRECT) return;
+
+    uint16_t x1 = ppu->cycle > NES_W ? NES_W : ppu->cycle - 1;
+    raster_compose(line, 0, x1, line->pixels);
+    line->mode = RASTER_DIRECT;
+}
+
+void ppu_raster_wait(_ppu* ppu) {
+    if (ppu->raster) raster_wait(ppu->raster);
+}
+
+void ppu_raster_end_frame(_ppu* ppu) {
+    if (ppu->raster) raster_end_frame(ppu->raster);
 }
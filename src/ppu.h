@@ -1,5 +1,6 @@
 #pragma once
 #include "cnes.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #define NES_W           256
@@ -7,13 +8,27 @@
 #define NES_ALL_WMAX    340
 #define NES_ALL_HMAX    261
 #define NES_PIXELS (NES_W * NES_H)
+#define NES_BURST_PHASES 3
 
 #define NMI_SIGNAL_LATENCY  14
 #define NMI_LATCH_THRESHOLD 12
+#define A12_LOW_FILTER      10
 
 typedef struct _cpu _cpu;
 typedef struct _cart _cart;
 typedef struct _gui _gui;
+typedef struct _raster _raster;
+typedef struct _raster_line _raster_line;
+
+typedef enum _pixel_format {
+    PIXEL_RGBA8888,
+    PIXEL_BGRA8888,
+    PIXEL_RGB565,
+    PIXEL_INDEX8,
+    PIXEL_INDEX16,
+    PIXEL_GRAY8,
+    PIXEL_FORMATS,
+} _pixel_format;
 
 typedef struct _sprite {
     uint8_t pos_y;
@@ -30,11 +45,56 @@ typedef struct _dma {
     uint8_t data;
 } _dma;
 
+typedef struct _bgrnd_state {
+    uint16_t vram_addr;
+    uint16_t pattern_low;
+    uint16_t pattern_high;
+    uint16_t attr_low;
+    uint16_t attr_high;
+    uint8_t next_id;
+    uint8_t next_attr;
+    uint8_t next_low;
+    uint8_t next_high;
+} _bgrnd_state;
+
+typedef struct _bgrnd_key {
+    uint8_t* ntbl[2];
+    uint32_t chr_gen;
+    _bgrnd_state start;
+    uint8_t fine_x;
+    uint8_t ppuctrl;
+    uint8_t ppumask;
+} _bgrnd_key;
+
+typedef struct _bgrnd_memo {
+    uint8_t valid;
+    uint8_t tiles;
+    _bgrnd_key key;
+    _bgrnd_state end;
+    uint8_t row[NES_W];
+    uint8_t tile_low[NES_W / 8];
+    uint8_t tile_high[NES_W / 8];
+    uint8_t tile_attr[NES_W / 8];
+} _bgrnd_memo;
+
+typedef enum _memo_state {
+    MEMO_OFF,
+    MEMO_RECORD,
+    MEMO_REPLAY,
+} _memo_state;
+
 typedef struct _ppu {
     uint8_t nametable[0x0800];
     uint8_t palette_idx[0x20];
+    uint32_t palette_rgba[0x20];
+    uint32_t palette_px[0x20];
 
-    uint32_t* pixels;
+    uint8_t* pixels;
+    uint8_t* own_pixels;
+    size_t pitch;
+    uint8_t format;
+    uint8_t pixel_size;
+    uint8_t no_output;
 
     uint8_t ppuctrl;
     uint8_t ppumask;
@@ -57,6 +117,19 @@ typedef struct _ppu {
     uint16_t cycle;
     uint16_t scanline;
 
+    uint32_t idle_dots;
+    uint32_t dot_debt;
+    uint64_t dots;
+
+    uint8_t a12;
+    uint64_t a12_low_since;
+
+    _bgrnd_memo* bgrnd_memo;
+    uint8_t memo_state;
+
+    _raster* raster;
+    _raster_line* raster_line;
+
     uint8_t bgrnd_next_id;
     uint8_t bgrnd_next_attr;
     uint8_t bgrnd_next_low;
@@ -77,7 +150,15 @@ typedef struct _ppu {
     uint8_t sprite_0_hit_possible;
     uint8_t sprite_0_rendered;
 
+    uint8_t sprite_0_predict;
+    uint8_t sprite_0_scan;
+    uint16_t sprite_0_dot;
+    uint16_t sprite_0_min_dot;
+    uint8_t sprite_0_x;
+    uint8_t sprite_0_bits;
+
     uint8_t odd_frame;
+    uint8_t burst_phase;
 
     uint8_t nmi_previous;
     uint8_t nmi_delay;
@@ -117,6 +198,43 @@ typedef enum _ppustatus_flag {
     VBLANK          = (1 << 7),
 } _ppustatus_flag;
 
+typedef enum _line_type {
+    LINE_VISIBLE,
+    LINE_VISIBLE_LAST,
+    LINE_POST_RENDER,
+    LINE_VBLANK_START,
+    LINE_VBLANK,
+    LINE_PRE_RENDER,
+    LINE_TYPES,
+} _line_type;
+
+typedef enum _dot_action {
+    DOT_SHIFT           = (1 << 0),
+    DOT_FETCH_NT        = (1 << 1),
+    DOT_FETCH_AT        = (1 << 2),
+    DOT_FETCH_LO        = (1 << 3),
+    DOT_FETCH_HI        = (1 << 4),
+    DOT_INC_X           = (1 << 5),
+    DOT_INC_Y           = (1 << 6),
+    DOT_LOAD_X          = (1 << 7),
+    DOT_LOAD_Y          = (1 << 8),
+    DOT_DUMMY_NT        = (1 << 9),
+    DOT_SPRITE_CLEAR    = (1 << 10),
+    DOT_SPRITE_EVAL     = (1 << 11),
+    DOT_SPRITE_FETCH    = (1 << 12),
+    DOT_SPRITE_LOAD     = (1 << 13),
+    DOT_PIXEL           = (1 << 14),
+    DOT_VBL_SET         = (1 << 15),
+    DOT_VBL_LATE        = (1 << 16),
+    DOT_VBL_CLEAR       = (1 << 17),
+    DOT_ODD_SKIP        = (1 << 18),
+    DOT_MEMO_BEGIN      = (1 << 19),
+    DOT_MEMO_END        = (1 << 20),
+    DOT_RASTER_BEGIN    = (1 << 21),
+    DOT_RASTER_COMMIT   = (1 << 22),
+    DOT_SPRITE_0        = (1 << 23),
+} _dot_action;
+
 typedef enum _ppureg_addr {
     PPUCTRL     = 0x2000,
     PPUMASK     = 0x2001,
@@ -146,8 +264,13 @@ typedef enum _sprite_attr {
 } _sprite_attr;
 
 CNES_RESULT ppu_clock(_ppu* ppu);
+uint32_t ppu_idle_span(_ppu* ppu);
+void ppu_sync(_ppu* ppu);
 void set_pixel(_ppu* ppu, uint16_t x, uint16_t y, uint32_t color);
 CNES_RESULT ppu_init(_ppu* ppu);
+void ppu_deinit(_ppu* ppu);
+CNES_RESULT ppu_set_target(_ppu* ppu, void* pixels, size_t pitch, _pixel_format format);
+void ppu_build_dot_table(void);
 uint8_t ppu_read(_ppu* ppu, uint16_t addr);
 void ppu_write(_ppu* ppu, uint16_t addr, uint8_t data);
 
@@ -171,11 +294,71 @@ void increment_scroll_y(_ppu* ppu);
 void transfer_addr_x(_ppu* ppu);
 void transfer_addr_y(_ppu* ppu);
 void load_bgrnd_shifters(_ppu* ppu);
-void update_shifters(_ppu* ppu);
+void update_bgrnd_shifters(_ppu* ppu);
+void update_sprite_shifters(_ppu* ppu);
+void fetch_bgrnd(_ppu* ppu, uint32_t actions);
 void ppu_update_nmi_state(_ppu* ppu);
 
-uint32_t get_color(_ppu* ppu, uint8_t palette, uint8_t emphasis, uint8_t pixel);
-uint8_t physical_nametable(_cart* cart, uint8_t logical);
+void sprite_0_begin(_ppu* ppu);
+void sprite_0_predict(_ppu* ppu, uint8_t first);
+void sprite_0_invalidate(_ppu* ppu);
+
+uint32_t get_color(_ppu* ppu, uint8_t palette, uint8_t pixel);
+uint32_t pixel_convert(uint8_t format, uint32_t rgba, uint16_t index);
+void update_palette_entry(_ppu* ppu, uint8_t index);
+void update_palette_cache(_ppu* ppu);
+
+void bgrnd_memo_begin(_ppu* ppu);
+void bgrnd_memo_end(_ppu* ppu);
+void bgrnd_memo_invalidate(_ppu* ppu, uint8_t* page, uint16_t offset);
+void ppu_bgrnd_memo_break(_ppu* ppu);
+
+void ppu_raster_begin(_ppu* ppu);
+void ppu_raster_commit(_ppu* ppu);
+void ppu_raster_break(_ppu* ppu);
+void ppu_raster_wait(_ppu* ppu);
+void ppu_raster_end_frame(_ppu* ppu);
+
+static inline uint8_t pixel_size(uint8_t format) {
+    switch (format) {
+    case PIXEL_RGBA8888:
+    case PIXEL_BGRA8888:
+        return 4;
+    case PIXEL_RGB565:
+    case PIXEL_INDEX16:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+static inline void store_pixels(uint8_t* row, uint16_t x0, uint16_t x1, const uint32_t* src, uint8_t size) {
+    switch (size) {
+    case 4:
+        for (uint16_t x = x0; x < x1; x++) ((uint32_t*)row)[x] = src[x];
+        break;
+    case 2:
+        for (uint16_t x = x0; x < x1; x++) ((uint16_t*)row)[x] = (uint16_t)src[x];
+        break;
+    default:
+        for (uint16_t x = x0; x < x1; x++) row[x] = (uint8_t)src[x];
+        break;
+    }
+}
+
+static inline void fill_pixels(uint8_t* row, uint16_t x0, uint16_t x1, uint32_t value, uint8_t size) {
+    switch (size) {
+    case 4:
+        for (uint16_t x = x0; x < x1; x++) ((uint32_t*)row)[x] = value;
+        break;
+    case 2:
+        for (uint16_t x = x0; x < x1; x++) ((uint16_t*)row)[x] = (uint16_t)value;
+        break;
+    default:
+        for (uint16_t x = x0; x < x1; x++) row[x] = (uint8_t)value;
+        break;
+    }
+}
 
 static inline uint8_t reverse_byte(uint8_t b) {
    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
@@ -0,0 +1,208 @@
+#include "raster.h"
+#include "cnes.h"
+#include "ppu.h"
+
+static void raster_draw(_raster* raster, uint16_t line) {
+    _raster_line* rec = &raster->lines[line];
+    uint8_t* row = raster->target + line * raster->pitch;
+
+    if (rec->mode == RASTER_DIRECT) {
+        store_pixels(row, 0, NES_W, rec->pixels, raster->pixel_size);
+    } else if (raster->pixel_size == 4) {
+        raster_compose(rec, 0, NES_W, (uint32_t*)row);
+    } else {
+        raster_compose(rec, 0, NES_W, rec->pixels);
+        store_pixels(row, 0, NES_W, rec->pixels, raster->pixel_size);
+    }
+}
+
+static int raster_worker(void* data) {
+    _raster* raster = (_raster*)data;
+
+    SDL_LockMutex(raster->lock);
+
+    while (!raster->quit) {
+        if (raster->drawn == raster->committed) {
+            SDL_WaitCondition(raster->wake, raster->lock);
+            continue;
+        }
+
+        uint16_t first = raster->drawn;
+        uint16_t last = raster->committed;
+        SDL_UnlockMutex(raster->lock);
+
+        for (uint16_t line = first; line < last; line++) {
+            raster_draw(raster, line);
+        }
+
+        SDL_LockMutex(raster->lock);
+        raster->drawn = last;
+        SDL_BroadcastCondition(raster->idle);
+    }
+
+    SDL_UnlockMutex(raster->lock);
+    return 0;
+}
+
+CNES_RESULT raster_init(_raster* raster, uint8_t* target, size_t pitch, uint8_t pixel_size) {
+    raster->target = target;
+    raster->pitch = pitch;
+    raster->pixel_size = pixel_size;
+    raster->committed = 0;
+    raster->drawn = 0;
+    raster->quit = 0;
+
+    raster->lock = SDL_CreateMutex();
+    raster->wake = SDL_CreateCondition();
+    raster->idle = SDL_CreateCondition();
+
+    if (!raster->lock || !raster->wake || !raster->idle) {
+        raster_deinit(raster);
+        return CNES_FAILURE;
+    }
+
+    raster->thread = SDL_CreateThread(raster_worker, "cnes raster", raster);
+    if (!raster->thread) {
+        raster_deinit(raster);
+        return CNES_FAILURE;
+    }
+
+    return CNES_SUCCESS;
+}
+
+void raster_deinit(_raster* raster) {
+    if (raster->thread) {
+        SDL_LockMutex(raster->lock);
+        raster->quit = 1;
+        SDL_SignalCondition(raster->wake);
+        SDL_UnlockMutex(raster->lock);
+
+        SDL_WaitThread(raster->thread, NULL);
+        raster->thread = NULL;
+    }
+
+    if (raster->idle) SDL_DestroyCondition(raster->idle);
+    if (raster->wake) SDL_DestroyCondition(raster->wake);
+    if (raster->lock) SDL_DestroyMutex(raster->lock);
+
+    raster->idle = NULL;
+    raster->wake = NULL;
+    raster->lock = NULL;
+}
+
+void raster_commit(_raster* raster, uint16_t line) {
+    SDL_LockMutex(raster->lock);
+
+    if (line >= raster->committed) {
+        raster->committed = line + 1;
+        SDL_SignalCondition(raster->wake);
+    }
+
+    SDL_UnlockMutex(raster->lock);
+}
+
+void raster_wait(_raster* raster) {
+    SDL_LockMutex(raster->lock);
+
+    while (raster->drawn != raster->committed) {
+        SDL_WaitCondition(raster->idle, raster->lock);
+    }
+
+    SDL_UnlockMutex(raster->lock);
+}
+
+// the next frame reuses the line records, so the worker has to be done with all of them first
+void raster_end_frame(_raster* raster) {
+    SDL_LockMutex(raster->lock);
+
+    while (raster->drawn != raster->committed) {
+        SDL_WaitCondition(raster->idle, raster->lock);
+    }
+
+    raster->committed = 0;
+    raster->drawn = 0;
+
+    SDL_UnlockMutex(raster->lock);
+}
+
+void raster_compose(const _raster_line* line, uint16_t x0, uint16_t x1, uint32_t* out) {
+    uint8_t low[RASTER_TILES + 2];
+    uint8_t high[RASTER_TILES + 2];
+    uint8_t attr_low[RASTER_TILES + 2];
+    uint8_t attr_high[RASTER_TILES + 2];
+
+    low[0] = (uint8_t)(line->shift_low >> 8);
+    low[1] = (uint8_t)line->shift_low;
+    high[0] = (uint8_t)(line->shift_high >> 8);
+    high[1] = (uint8_t)line->shift_high;
+    attr_low[0] = (uint8_t)(line->shift_attr_low >> 8);
+    attr_low[1] = (uint8_t)line->shift_attr_low;
+    attr_high[0] = (uint8_t)(line->shift_attr_high >> 8);
+    attr_high[1] = (uint8_t)line->shift_attr_high;
+
+    for (uint8_t t = 0; t < RASTER_TILES; t++) {
+        low[t + 2] = line->tile_low[t];
+        high[t + 2] = line->tile_high[t];
+        attr_low[t + 2] = (line->tile_attr[t] & 0x01) ? 0xFF : 0x00;
+        attr_high[t + 2] = (line->tile_attr[t] & 0x02) ? 0xFF : 0x00;
+    }
+
+    uint8_t mask = line->ppumask;
+    uint8_t rendering = mask & (BGRND_EN | SPRITE_EN);
+
+    for (uint16_t x = x0; x < x1; x++) {
+        uint8_t bgrnd_pixel = 0x00;
+        uint8_t bgrnd_palette = 0x00;
+
+        if (rendering) {
+            uint16_t p = x + line->fine_x;
+            uint8_t t = (uint8_t)(p >> 3);
+            uint8_t bit = 7 - (p & 0x07);
+
+            bgrnd_pixel = (uint8_t)((((high[t] >> bit) & 1) << 1) | ((low[t] >> bit) & 1));
+            bgrnd_palette = (uint8_t)((((attr_high[t] >> bit) & 1) << 1) | ((attr_low[t] >> bit) & 1));
+        }
+
+        if (!(mask & BGRND_EN) || (!(mask & BGRND_LC_EN) && x < 8)) {
+            bgrnd_pixel = 0;
+        }
+
+        uint8_t sprite_pixel = 0x00;
+        uint8_t sprite_palette = 0x00;
+        uint8_t sprite_priority = 0x00;
+
+        if (mask & SPRITE_EN) {
+            for (uint8_t i = 0; i < line->sprite_count; i++) {
+                uint16_t dx = x - line->sprite_x[i];
+                if (x < line->sprite_x[i] || dx > 7) continue;
+
+                uint8_t bit = 7 - (uint8_t)dx;
+                sprite_pixel = (uint8_t)((((line->sprite_high[i] >> bit) & 1) << 1) |
+                                         ((line->sprite_low[i] >> bit) & 1));
+
+                if (sprite_pixel) {
+                    sprite_palette = (line->sprite_attr[i] & SPRITE_PALETTE) + 0x04;
+                    sprite_priority = !(line->sprite_attr[i] & PRIORITY);
+                    break;
+                }
+            }
+        }
+
+        if (!(mask & SPRITE_LC_EN) && x < 8) {
+            sprite_pixel = 0;
+        }
+
+        uint8_t pixel = 0x00;
+        uint8_t palette = 0x00;
+
+        if (sprite_pixel && (!bgrnd_pixel || sprite_priority)) {
+            pixel = sprite_pixel;
+            palette = sprite_palette;
+        } else if (bgrnd_pixel) {
+            pixel = bgrnd_pixel;
+            palette = bgrnd_palette;
+        }
+
+        out[x] = line->palette[(palette << 2) | pixel];
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "cnes.h"
+#include "ppu.h"
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RASTER_TILES    (NES_W / 8)
+
+typedef enum _raster_mode {
+    RASTER_COMPOSE,
+    RASTER_DIRECT,
+} _raster_mode;
+
+typedef struct _raster_line {
+    uint8_t mode;
+    uint8_t fine_x;
+    uint8_t ppumask;
+
+    uint16_t shift_low;
+    uint16_t shift_high;
+    uint16_t shift_attr_low;
+    uint16_t shift_attr_high;
+
+    uint8_t tile_low[RASTER_TILES];
+    uint8_t tile_high[RASTER_TILES];
+    uint8_t tile_attr[RASTER_TILES];
+
+    uint8_t sprite_count;
+    uint8_t sprite_x[0x08];
+    uint8_t sprite_attr[0x08];
+    uint8_t sprite_low[0x08];
+    uint8_t sprite_high[0x08];
+
+    uint32_t palette[0x20];
+    uint32_t pixels[NES_W];
+} _raster_line;
+
+typedef struct _raster {
+    _raster_line lines[NES_H];
+    uint8_t* target;
+    size_t pitch;
+    uint8_t pixel_size;
+
+    SDL_Thread* thread;
+    SDL_Mutex* lock;
+    SDL_Condition* wake;
+    SDL_Condition* idle;
+
+    uint16_t committed;
+    uint16_t drawn;
+    uint8_t quit;
+} _raster;
+
+CNES_RESULT raster_init(_raster* raster, uint8_t* target, size_t pitch, uint8_t pixel_size);
+void raster_deinit(_raster* raster);
+void raster_commit(_raster* raster, uint16_t line);
+void raster_wait(_raster* raster);
+void raster_end_frame(_raster* raster);
+void raster_compose(const _raster_line* line, uint16_t x0, uint16_t x1, uint32_t* out);
@@ -0,0 +1,57 @@
+#include "reglog.h"
+#include "cnes.h"
+#include "ppu.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+CNES_RESULT reglog_init(_reglog* log) {
+    if (!log->entries) {
+        log->entries = (_reglog_entry*)calloc(REGLOG_CAPACITY, sizeof(_reglog_entry));
+    }
+
+    if (!log->entries) {
+        fprintf(stderr, "[ERROR] Failed to allocate register log!\n");
+        return CNES_FAILURE;
+    }
+
+    log->head = 0;
+    log->frame_begin = 0;
+    log->last_begin = 0;
+    log->last_end = 0;
+
+    return CNES_SUCCESS;
+}
+
+void reglog_deinit(_reglog* log) {
+    free(log->entries);
+    log->entries = NULL;
+}
+
+void reglog_record(_reglog* log, _ppu* ppu, uint16_t pc, uint16_t addr, uint8_t data) {
+    ppu_sync(ppu);
+
+    _reglog_entry* entry = &log->entries[log->head++ & REGLOG_MASK];
+    entry->addr = addr;
+    entry->pc = pc;
+    entry->scanline = ppu->scanline;
+    entry->dot = ppu->cycle;
+    entry->data = data;
+}
+
+void reglog_end_frame(_reglog* log) {
+    log->last_begin = log->frame_begin;
+    log->last_end = log->head;
+    log->frame_begin = log->head;
+
+    if (log->last_end - log->last_begin > REGLOG_CAPACITY) {
+        log->last_begin = log->last_end - REGLOG_CAPACITY;
+    }
+}
+
+uint32_t reglog_frame_count(_reglog* log) {
+    return log->last_end - log->last_begin;
+}
+
+const _reglog_entry* reglog_frame_entry(_reglog* log, uint32_t index) {
+    return &log->entries[(log->last_begin + index) & REGLOG_MASK];
+}
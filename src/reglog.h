@@ -0,0 +1,31 @@
+#pragma once
+#include "cnes.h"
+#include <stdint.h>
+
+#define REGLOG_CAPACITY 0x2000
+#define REGLOG_MASK     (REGLOG_CAPACITY - 1)
+
+typedef struct _ppu _ppu;
+
+typedef struct _reglog_entry {
+    uint16_t addr;
+    uint16_t pc;
+    uint16_t scanline;
+    uint16_t dot;
+    uint8_t data;
+} _reglog_entry;
+
+typedef struct _reglog {
+    _reglog_entry* entries;
+    uint32_t head;
+    uint32_t frame_begin;
+    uint32_t last_begin;
+    uint32_t last_end;
+} _reglog;
+
+CNES_RESULT reglog_init(_reglog* log);
+void reglog_deinit(_reglog* log);
+void reglog_record(_reglog* log, _ppu* ppu, uint16_t pc, uint16_t addr, uint8_t data);
+void reglog_end_frame(_reglog* log);
+uint32_t reglog_frame_count(_reglog* log);
+const _reglog_entry* reglog_frame_entry(_reglog* log, uint32_t index);
@@ -0,0 +1,165 @@
+#include "resample.h"
+#include "cnes.h"
+#include "fixed.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESAMPLE_FRAC_BITS  32
+#define RESAMPLE_BLEND_BITS (RESAMPLE_FRAC_BITS - RESAMPLE_PHASE_BITS)
+#define RESAMPLE_PASSBAND   1932735283u
+#define RESAMPLE_BETA       (8 << 16)
+
+static void build_kernel(_resampler* rs, uint32_t cutoff) {
+    int32_t half = rs->taps / 2;
+    int64_t norm = fixed_bessel_i0(RESAMPLE_BETA);
+    int32_t taps[RESAMPLE_MAX_TAPS];
+
+    for (uint16_t p = 0; p <= RESAMPLE_PHASES; p++) {
+        for (uint16_t k = 0; k < rs->taps; k++) {
+            int32_t t = (k - (half - 1)) * 65536 - p * (65536 / RESAMPLE_PHASES);
+            int64_t r = t / half;
+
+            if (r <= -65536 || r >= 65536) {
+                taps[k] = 0;
+                continue;
+            }
+
+            uint32_t x = (uint32_t)(((uint64_t)RESAMPLE_BETA * fixed_sqrt((1ull << 32) - (uint64_t)(r * r))) >> 16);
+            int64_t window = fixed_bessel_i0(x) * FIXED_ONE / norm;
+
+            taps[k] = (int32_t)((fixed_sinc(cutoff, t) * window) >> FIXED_BITS);
+        }
+
+        fixed_normalize(taps, rs->kernel + (size_t)p * rs->taps, rs->taps, RESAMPLE_KERNEL_BITS);
+    }
+}
+
+CNES_RESULT resample_init(_resampler* rs, uint32_t in_rate, uint32_t out_rate, uint8_t zero_crossings) {
+    memset(rs, 0, sizeof(_resampler));
+
+    if (!in_rate || !out_rate || out_rate > in_rate || !zero_crossings) {
+        fprintf(stderr, "[ERROR] Invalid resampler rates!\n");
+        return CNES_FAILURE;
+    }
+
+    uint32_t width = 2u * zero_crossings * ((in_rate + out_rate - 1) / out_rate);
+    width = (width + 7) & ~7u;
+
+    if (width > RESAMPLE_MAX_TAPS) {
+        fprintf(stderr, "[ERROR] Resampler kernel too long!\n");
+        return CNES_FAILURE;
+    }
+
+    rs->taps = (uint16_t)width;
+    rs->step = (((uint64_t)in_rate << RESAMPLE_FRAC_BITS) + out_rate / 2) / out_rate;
+
+    rs->kernel = (int16_t*)calloc((size_t)(RESAMPLE_PHASES + 1) * rs->taps, sizeof(int16_t));
+    rs->history = (int16_t*)calloc(RESAMPLE_CHUNK + rs->taps, sizeof(int16_t));
+
+    if (!rs->kernel || !rs->history) {
+        fprintf(stderr, "[ERROR] Failed to allocate resampler!\n");
+        resample_deinit(rs);
+        return CNES_FAILURE;
+    }
+
+    build_kernel(rs, (uint32_t)((uint64_t)RESAMPLE_PASSBAND * out_rate / in_rate));
+    resample_clear(rs);
+
+    return CNES_SUCCESS;
+}
+
+void resample_deinit(_resampler* rs) {
+    free(rs->kernel);
+    free(rs->history);
+    rs->kernel = NULL;
+    rs->history = NULL;
+}
+
+void resample_clear(_resampler* rs) {
+    if (rs->history) memset(rs->history, 0, (RESAMPLE_CHUNK + rs->taps) * sizeof(int16_t));
+    rs->buffered = rs->taps;
+    rs->pos = 0;
+}
+
+// integer sums are exact, so every path below produces the same bits
+static int32_t dot(const int16_t* in, const int16_t* k, uint16_t taps) {
+#if defined(CNES_SSE2)
+    __m128i acc = _mm_setzero_si128();
+
+    for (uint16_t i = 0; i < taps; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(k + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+    }
+
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+    return _mm_cvtsi128_si32(acc);
+#elif defined(CNES_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+
+    for (uint16_t i = 0; i < taps; i += 8) {
+        int16x8_t a = vld1q_s16(in + i);
+        int16x8_t b = vld1q_s16(k + i);
+        acc = vmlal_s16(acc, vget_low_s16(a), vget_low_s16(b));
+        acc = vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b));
+    }
+
+    int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    return vget_lane_s32(vpadd_s32(sum, sum), 0);
+#else
+    int32_t acc = 0;
+
+    for (uint16_t i = 0; i < taps; i++) {
+        acc += in[i] * k[i];
+    }
+
+    return acc;
+#endif
+}
+
+uint32_t resample_run(_resampler* rs, const int16_t* in, uint32_t count, int16_t* out, uint32_t max_out) {
+    uint32_t produced = 0;
+
+    while (count) {
+        uint32_t room = RESAMPLE_CHUNK + rs->taps - rs->buffered;
+        uint32_t take = count < room ? count : room;
+        if (!take) break;
+
+        memcpy(rs->history + rs->buffered, in, take * sizeof(int16_t));
+        rs->buffered += take;
+        in += take;
+        count -= take;
+
+        uint64_t end = (uint64_t)(rs->buffered - rs->taps) << RESAMPLE_FRAC_BITS;
+
+        while (rs->pos < end && produced < max_out) {
+            uint32_t index = (uint32_t)(rs->pos >> RESAMPLE_FRAC_BITS);
+            uint32_t frac = (uint32_t)rs->pos;
+            uint32_t phase = frac >> RESAMPLE_BLEND_BITS;
+            int64_t blend = frac & ((1u << RESAMPLE_BLEND_BITS) - 1);
+
+            const int16_t* k0 = rs->kernel + (size_t)phase * rs->taps;
+            const int16_t* history = rs->history + index + 1;
+
+            int64_t d0 = dot(history, k0, rs->taps);
+            int64_t d1 = dot(history, k0 + rs->taps, rs->taps);
+            int64_t s = d0 + (((d1 - d0) * blend) >> RESAMPLE_BLEND_BITS);
+
+            s = (s + (1 << (RESAMPLE_KERNEL_BITS - 1))) >> RESAMPLE_KERNEL_BITS;
+            out[produced++] = (int16_t)(s > INT16_MAX ? INT16_MAX : s < INT16_MIN ? INT16_MIN : s);
+            rs->pos += rs->step;
+        }
+
+        uint32_t consumed = (uint32_t)(rs->pos >> RESAMPLE_FRAC_BITS);
+        if (consumed > rs->buffered - rs->taps) consumed = rs->buffered - rs->taps;
+
+        memmove(rs->history, rs->history + consumed, (rs->buffered - consumed) * sizeof(int16_t));
+        rs->buffered -= consumed;
+        rs->pos -= (uint64_t)consumed << RESAMPLE_FRAC_BITS;
+    }
+
+    return produced;
+}
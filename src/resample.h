@@ -0,0 +1,25 @@
+#pragma once
+#include "cnes.h"
+#include <stdint.h>
+
+#define RESAMPLE_PHASE_BITS 8
+#define RESAMPLE_PHASES     (1 << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_CHUNK      1024
+#define RESAMPLE_MAX_TAPS   512
+#define RESAMPLE_KERNEL_BITS 15
+
+typedef struct _resampler {
+    int16_t* kernel;
+    uint16_t taps;
+
+    int16_t* history;
+    uint32_t buffered;
+
+    uint64_t step;
+    uint64_t pos;
+} _resampler;
+
+CNES_RESULT resample_init(_resampler* rs, uint32_t in_rate, uint32_t out_rate, uint8_t zero_crossings);
+void resample_deinit(_resampler* rs);
+void resample_clear(_resampler* rs);
+uint32_t resample_run(_resampler* rs, const int16_t* in, uint32_t count, int16_t* out, uint32_t max_out);
@@ -0,0 +1,41 @@
+#include "ring.h"
+#include <string.h>
+
+void ring_reset(_ring* ring) {
+    SDL_SetAtomicU32(&ring->head, 0);
+    SDL_SetAtomicU32(&ring->tail, 0);
+}
+
+uint32_t ring_count(_ring* ring) {
+    return SDL_GetAtomicU32(&ring->head) - SDL_GetAtomicU32(&ring->tail);
+}
+
+uint32_t ring_write(_ring* ring, const int16_t* samples, uint32_t count) {
+    uint32_t head = SDL_GetAtomicU32(&ring->head);
+    uint32_t free = RING_CAPACITY - (head - SDL_GetAtomicU32(&ring->tail));
+    if (count > free) count = free;
+
+    uint32_t at = head & (RING_CAPACITY - 1);
+    uint32_t first = RING_CAPACITY - at < count ? RING_CAPACITY - at : count;
+
+    memcpy(ring->samples + at, samples, first * sizeof(int16_t));
+    memcpy(ring->samples, samples + first, (count - first) * sizeof(int16_t));
+
+    SDL_SetAtomicU32(&ring->head, head + count);
+    return count;
+}
+
+uint32_t ring_read(_ring* ring, int16_t* samples, uint32_t count) {
+    uint32_t tail = SDL_GetAtomicU32(&ring->tail);
+    uint32_t avail = SDL_GetAtomicU32(&ring->head) - tail;
+    if (count > avail) count = avail;
+
+    uint32_t at = tail & (RING_CAPACITY - 1);
+    uint32_t first = RING_CAPACITY - at < count ? RING_CAPACITY - at : count;
+
+    memcpy(samples, ring->samples + at, first * sizeof(int16_t));
+    memcpy(samples + first, ring->samples, (count - first) * sizeof(int16_t));
+
+    SDL_SetAtomicU32(&ring->tail, tail + count);
+    return count;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <SDL3/SDL_atomic.h>
+#include <stdint.h>
+
+#define RING_CAPACITY 16384
+
+// single producer, single consumer; head is only written by the producer, tail by the consumer
+typedef struct _ring {
+    int16_t samples[RING_CAPACITY];
+    SDL_AtomicU32 head;
+    SDL_AtomicU32 tail;
+} _ring;
+
+void ring_reset(_ring* ring);
+uint32_t ring_count(_ring* ring);
+uint32_t ring_write(_ring* ring, const int16_t* samples, uint32_t count);
+uint32_t ring_read(_ring* ring, int16_t* samples, uint32_t count);
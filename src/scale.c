@@ -0,0 +1,327 @@
+#include "scale.h"
+#include "cnes.h"
+#include "ppu.h"
+#include "simd.h"
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(CNES_SSE2)
+
+typedef __m128i vec_u32;
+typedef __m128 vec_f32;
+
+static inline vec_u32 u_load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void u_store(uint32_t* p, vec_u32 v) { _mm_storeu_si128((__m128i*)p, v); }
+static inline vec_u32 u_eq(vec_u32 a, vec_u32 b) { return _mm_cmpeq_epi32(a, b); }
+static inline vec_u32 u_and(vec_u32 a, vec_u32 b) { return _mm_and_si128(a, b); }
+static inline vec_u32 u_or(vec_u32 a, vec_u32 b) { return _mm_or_si128(a, b); }
+static inline vec_u32 u_andnot(vec_u32 a, vec_u32 b) { return _mm_andnot_si128(b, a); }
+static inline vec_u32 u_select(vec_u32 m, vec_u32 a, vec_u32 b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+static inline vec_u32 u_zip_lo(vec_u32 a, vec_u32 b) { return _mm_unpacklo_epi32(a, b); }
+static inline vec_u32 u_zip_hi(vec_u32 a, vec_u32 b) { return _mm_unpackhi_epi32(a, b); }
+static inline vec_u32 u_avg(vec_u32 a, vec_u32 b) { return _mm_avg_epu8(a, b); }
+
+static inline vec_f32 f_load(const float* p) { return _mm_loadu_ps(p); }
+static inline vec_f32 f_add(vec_f32 a, vec_f32 b) { return _mm_add_ps(a, b); }
+static inline vec_f32 f_absdiff(vec_f32 a, vec_f32 b) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(a, b)); }
+static inline vec_f32 f_scale(vec_f32 a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+static inline vec_u32 f_lt(vec_f32 a, vec_f32 b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+static inline vec_u32 f_le(vec_f32 a, vec_f32 b) { return _mm_castps_si128(_mm_cmple_ps(a, b)); }
+
+#elif defined(CNES_NEON)
+
+typedef uint32x4_t vec_u32;
+typedef float32x4_t vec_f32;
+
+static inline vec_u32 u_load(const uint32_t* p) { return vld1q_u32(p); }
+static inline void u_store(uint32_t* p, vec_u32 v) { vst1q_u32(p, v); }
+static inline vec_u32 u_eq(vec_u32 a, vec_u32 b) { return vceqq_u32(a, b); }
+static inline vec_u32 u_and(vec_u32 a, vec_u32 b) { return vandq_u32(a, b); }
+static inline vec_u32 u_or(vec_u32 a, vec_u32 b) { return vorrq_u32(a, b); }
+static inline vec_u32 u_andnot(vec_u32 a, vec_u32 b) { return vbicq_u32(a, b); }
+static inline vec_u32 u_select(vec_u32 m, vec_u32 a, vec_u32 b) { return vbslq_u32(m, a, b); }
+static inline vec_u32 u_zip_lo(vec_u32 a, vec_u32 b) { return vzipq_u32(a, b).val[0]; }
+static inline vec_u32 u_zip_hi(vec_u32 a, vec_u32 b) { return vzipq_u32(a, b).val[1]; }
+
+static inline vec_u32 u_avg(vec_u32 a, vec_u32 b) {
+    return vreinterpretq_u32_u8(vrhaddq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b)));
+}
+
+static inline vec_f32 f_load(const float* p) { return vld1q_f32(p); }
+static inline vec_f32 f_add(vec_f32 a, vec_f32 b) { return vaddq_f32(a, b); }
+static inline vec_f32 f_absdiff(vec_f32 a, vec_f32 b) { return vabdq_f32(a, b); }
+static inline vec_f32 f_scale(vec_f32 a, float s) { return vmulq_n_f32(a, s); }
+static inline vec_u32 f_lt(vec_f32 a, vec_f32 b) { return vcltq_f32(a, b); }
+static inline vec_u32 f_le(vec_f32 a, vec_f32 b) { return vcleq_f32(a, b); }
+
+#else
+
+typedef struct vec_u32 { uint32_t v[4]; } vec_u32;
+typedef struct vec_f32 { float v[4]; } vec_f32;
+
+#define VEC_MAP(type, expr) do { type r; for (uint8_t i = 0; i < 4; i++) r.v[i] = (expr); return r; } while (0)
+
+static inline vec_u32 u_load(const uint32_t* p) { VEC_MAP(vec_u32, p[i]); }
+static inline void u_store(uint32_t* p, vec_u32 v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline vec_u32 u_eq(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, a.v[i] == b.v[i] ? 0xFFFFFFFF : 0); }
+static inline vec_u32 u_and(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, a.v[i] & b.v[i]); }
+static inline vec_u32 u_or(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, a.v[i] | b.v[i]); }
+static inline vec_u32 u_andnot(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, a.v[i] & ~b.v[i]); }
+static inline vec_u32 u_select(vec_u32 m, vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, (m.v[i] & a.v[i]) | (~m.v[i] & b.v[i])); }
+static inline vec_u32 u_zip_lo(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, (i & 1 ? b : a).v[i >> 1]); }
+static inline vec_u32 u_zip_hi(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, (i & 1 ? b : a).v[2 + (i >> 1)]); }
+static inline vec_u32 u_avg(vec_u32 a, vec_u32 b) { VEC_MAP(vec_u32, (a.v[i] | b.v[i]) - (((a.v[i] ^ b.v[i]) & 0xFEFEFEFE) >> 1)); }
+
+static inline vec_f32 f_load(const float* p) { VEC_MAP(vec_f32, p[i]); }
+static inline vec_f32 f_add(vec_f32 a, vec_f32 b) { VEC_MAP(vec_f32, a.v[i] + b.v[i]); }
+static inline vec_f32 f_absdiff(vec_f32 a, vec_f32 b) { VEC_MAP(vec_f32, a.v[i] > b.v[i] ? a.v[i] - b.v[i] : b.v[i] - a.v[i]); }
+static inline vec_f32 f_scale(vec_f32 a, float s) { VEC_MAP(vec_f32, a.v[i] * s); }
+static inline vec_u32 f_lt(vec_f32 a, vec_f32 b) { VEC_MAP(vec_u32, a.v[i] < b.v[i] ? 0xFFFFFFFF : 0); }
+static inline vec_u32 f_le(vec_f32 a, vec_f32 b) { VEC_MAP(vec_u32, a.v[i] <= b.v[i] ? 0xFFFFFFFF : 0); }
+
+#endif
+
+static inline uint32_t* out_row(_scale* scale, uint16_t y) {
+    return (uint32_t*)(scale->out + y * scale->out_pitch);
+}
+
+static void nearest_row(_scale* scale, uint16_t y, uint8_t factor) {
+    const uint32_t* src = &scale->src[y + SCALE_PAD][SCALE_PAD];
+    uint32_t* dst = out_row(scale, y * factor);
+
+    for (uint16_t x = 0; x < NES_W; x += 4) {
+        vec_u32 e = u_load(src + x);
+
+        if (factor == 2) {
+            u_store(dst + x * 2, u_zip_lo(e, e));
+            u_store(dst + x * 2 + 4, u_zip_hi(e, e));
+        } else if (factor == 4) {
+            vec_u32 lo = u_zip_lo(e, e);
+            vec_u32 hi = u_zip_hi(e, e);
+            u_store(dst + x * 4, u_zip_lo(lo, lo));
+            u_store(dst + x * 4 + 4, u_zip_hi(lo, lo));
+            u_store(dst + x * 4 + 8, u_zip_lo(hi, hi));
+            u_store(dst + x * 4 + 12, u_zip_hi(hi, hi));
+        } else {
+            for (uint8_t i = 0; i < 4; i++) {
+                fill_pixels((uint8_t*)dst, (x + i) * factor, (x + i + 1) * factor, src[x + i], 4);
+            }
+        }
+    }
+
+    for (uint8_t k = 1; k < factor; k++) {
+        memcpy(out_row(scale, y * factor + k), dst, NES_W * factor * sizeof(uint32_t));
+    }
+}
+
+static void scale2x_row(_scale* scale, uint16_t y) {
+    const uint32_t* src = &scale->src[y + SCALE_PAD][SCALE_PAD];
+    uint32_t* dst0 = out_row(scale, y * 2);
+    uint32_t* dst1 = out_row(scale, y * 2 + 1);
+
+    for (uint16_t x = 0; x < NES_W; x += 4) {
+        const uint32_t* p = src + x;
+        vec_u32 b = u_load(p - SCALE_STRIDE);
+        vec_u32 d = u_load(p - 1);
+        vec_u32 e = u_load(p);
+        vec_u32 f = u_load(p + 1);
+        vec_u32 h = u_load(p + SCALE_STRIDE);
+
+        vec_u32 active = u_andnot(u_andnot(u_eq(e, e), u_eq(b, h)), u_eq(d, f));
+
+        vec_u32 e0 = u_select(u_and(active, u_eq(d, b)), d, e);
+        vec_u32 e1 = u_select(u_and(active, u_eq(b, f)), f, e);
+        vec_u32 e2 = u_select(u_and(active, u_eq(d, h)), d, e);
+        vec_u32 e3 = u_select(u_and(active, u_eq(h, f)), f, e);
+
+        u_store(dst0 + x * 2, u_zip_lo(e0, e1));
+        u_store(dst0 + x * 2 + 4, u_zip_hi(e0, e1));
+        u_store(dst1 + x * 2, u_zip_lo(e2, e3));
+        u_store(dst1 + x * 2 + 4, u_zip_hi(e2, e3));
+    }
+}
+
+static void store3(uint32_t* dst, vec_u32 a, vec_u32 b, vec_u32 c) {
+    uint32_t lanes[3][4];
+    u_store(lanes[0], a);
+    u_store(lanes[1], b);
+    u_store(lanes[2], c);
+
+    for (uint8_t i = 0; i < 4; i++) {
+        dst[i * 3 + 0] = lanes[0][i];
+        dst[i * 3 + 1] = lanes[1][i];
+        dst[i * 3 + 2] = lanes[2][i];
+    }
+}
+
+static void scale3x_row(_scale* scale, uint16_t y) {
+    const uint32_t* src = &scale->src[y + SCALE_PAD][SCALE_PAD];
+    uint32_t* dst0 = out_row(scale, y * 3);
+    uint32_t* dst1 = out_row(scale, y * 3 + 1);
+    uint32_t* dst2 = out_row(scale, y * 3 + 2);
+
+    for (uint16_t x = 0; x < NES_W; x += 4) {
+        const uint32_t* p = src + x;
+        vec_u32 a = u_load(p - SCALE_STRIDE - 1);
+        vec_u32 b = u_load(p - SCALE_STRIDE);
+        vec_u32 c = u_load(p - SCALE_STRIDE + 1);
+        vec_u32 d = u_load(p - 1);
+        vec_u32 e = u_load(p);
+        vec_u32 f = u_load(p + 1);
+        vec_u32 g = u_load(p + SCALE_STRIDE - 1);
+        vec_u32 h = u_load(p + SCALE_STRIDE);
+        vec_u32 i = u_load(p + SCALE_STRIDE + 1);
+
+        vec_u32 active = u_andnot(u_andnot(u_eq(e, e), u_eq(b, h)), u_eq(d, f));
+        vec_u32 db = u_and(active, u_eq(d, b));
+        vec_u32 bf = u_and(active, u_eq(b, f));
+        vec_u32 dh = u_and(active, u_eq(d, h));
+        vec_u32 hf = u_and(active, u_eq(h, f));
+
+        vec_u32 ea = u_eq(e, a);
+        vec_u32 ec = u_eq(e, c);
+        vec_u32 eg = u_eq(e, g);
+        vec_u32 ei = u_eq(e, i);
+
+        vec_u32 e0 = u_select(db, d, e);
+        vec_u32 e1 = u_select(u_or(u_andnot(db, ec), u_andnot(bf, ea)), b, e);
+        vec_u32 e2 = u_select(bf, f, e);
+        vec_u32 e3 = u_select(u_or(u_andnot(db, eg), u_andnot(dh, ea)), d, e);
+        vec_u32 e5 = u_select(u_or(u_andnot(bf, ei), u_andnot(hf, ec)), f, e);
+        vec_u32 e6 = u_select(dh, d, e);
+        vec_u32 e7 = u_select(u_or(u_andnot(dh, ei), u_andnot(hf, eg)), h, e);
+        vec_u32 e8 = u_select(hf, f, e);
+
+        store3(dst0 + x * 3, e0, e1, e2);
+        store3(dst1 + x * 3, e3, e, e5);
+        store3(dst2 + x * 3, e6, e7, e8);
+    }
+}
+
+static inline vec_f32 yuv_dist(const float* const yuv[3], ptrdiff_t p, ptrdiff_t q) {
+    vec_f32 dist = f_absdiff(f_load(yuv[0] + p), f_load(yuv[0] + q));
+    dist = f_add(dist, f_absdiff(f_load(yuv[1] + p), f_load(yuv[1] + q)));
+    return f_add(dist, f_absdiff(f_load(yuv[2] + p), f_load(yuv[2] + q)));
+}
+
+// r and d step "right" and "down" as seen from the corner being resolved
+static vec_u32 xbr_corner(const uint32_t* src, const float* const yuv[3], ptrdiff_t r, ptrdiff_t d) {
+    vec_u32 e = u_load(src);
+    vec_u32 f = u_load(src + r);
+    vec_u32 h = u_load(src + d);
+
+    vec_f32 edge = f_add(yuv_dist(yuv, 0, r - d), yuv_dist(yuv, 0, d - r));
+    edge = f_add(edge, f_add(yuv_dist(yuv, r + d, 2 * r), yuv_dist(yuv, r + d, 2 * d)));
+    edge = f_add(edge, f_scale(yuv_dist(yuv, d, r), 4.0f));
+
+    vec_f32 cross = f_add(yuv_dist(yuv, d, -r), yuv_dist(yuv, d, r + 2 * d));
+    cross = f_add(cross, f_add(yuv_dist(yuv, r, 2 * r + d), yuv_dist(yuv, r, -d)));
+    cross = f_add(cross, f_scale(yuv_dist(yuv, 0, r + d), 4.0f));
+
+    vec_u32 blend = u_andnot(u_andnot(f_lt(edge, cross), u_eq(e, f)), u_eq(e, h));
+    vec_u32 pick = u_select(f_le(yuv_dist(yuv, 0, r), yuv_dist(yuv, 0, d)), f, h);
+
+    return u_select(blend, u_avg(e, pick), e);
+}
+
+static void xbr2x_row(_scale* scale, uint16_t y) {
+    const ptrdiff_t s = SCALE_STRIDE;
+    uint32_t* dst0 = out_row(scale, y * 2);
+    uint32_t* dst1 = out_row(scale, y * 2 + 1);
+
+    for (uint16_t x = 0; x < NES_W; x += 4) {
+        const uint32_t* src = &scale->src[y + SCALE_PAD][x + SCALE_PAD];
+        const float* const yuv[3] = {
+            &scale->yuv[0][y + SCALE_PAD][x + SCALE_PAD],
+            &scale->yuv[1][y + SCALE_PAD][x + SCALE_PAD],
+            &scale->yuv[2][y + SCALE_PAD][x + SCALE_PAD],
+        };
+
+        vec_u32 e0 = xbr_corner(src, yuv, -1, -s);
+        vec_u32 e1 = xbr_corner(src, yuv, 1, -s);
+        vec_u32 e2 = xbr_corner(src, yuv, -1, s);
+        vec_u32 e3 = xbr_corner(src, yuv, 1, s);
+
+        u_store(dst0 + x * 2, u_zip_lo(e0, e1));
+        u_store(dst0 + x * 2 + 4, u_zip_hi(e0, e1));
+        u_store(dst1 + x * 2, u_zip_lo(e2, e3));
+        u_store(dst1 + x * 2 + 4, u_zip_hi(e2, e3));
+    }
+}
+
+static void scale_rows(void* data, uint16_t first, uint16_t last) {
+    _scale* scale = (_scale*)data;
+
+    for (uint16_t y = first; y < last; y++) {
+        switch (scale->kind) {
+            case SCALER_NEAREST2X:
+            case SCALER_NEAREST3X:
+            case SCALER_NEAREST4X:
+                nearest_row(scale, y, SCALER_FACTORS[scale->kind]);
+                break;
+            case SCALER_SCALE2X:
+                scale2x_row(scale, y);
+                break;
+            case SCALER_SCALE3X:
+                scale3x_row(scale, y);
+                break;
+            case SCALER_XBR2X:
+                xbr2x_row(scale, y);
+                break;
+        }
+    }
+}
+
+static void load_source(_scale* scale, const uint8_t* in, size_t in_pitch, uint8_t yuv) {
+    for (int16_t y = 0; y < SCALE_ROWS; y++) {
+        int16_t sy = y - SCALE_PAD;
+        sy = sy < 0 ? 0 : sy >= NES_H ? NES_H - 1 : sy;
+
+        uint32_t* row = scale->src[y];
+        memcpy(row + SCALE_PAD, in + sy * in_pitch, NES_W * sizeof(uint32_t));
+
+        for (uint8_t x = 0; x < SCALE_PAD; x++) {
+            row[x] = row[SCALE_PAD];
+            row[SCALE_STRIDE - 1 - x] = row[SCALE_STRIDE - 1 - SCALE_PAD];
+        }
+
+        if (!yuv) continue;
+
+        for (uint16_t x = 0; x < SCALE_STRIDE; x++) {
+            const uint8_t* c = (const uint8_t*)&row[x];
+            float r = c[0], g = c[1], b = c[2];
+
+            scale->yuv[0][y][x] = 48.0f * (0.299f * r + 0.587f * g + 0.114f * b);
+            scale->yuv[1][y][x] = 7.0f * (-0.169f * r - 0.331f * g + 0.500f * b);
+            scale->yuv[2][y][x] = 6.0f * (0.500f * r - 0.419f * g - 0.081f * b);
+        }
+    }
+}
+
+CNES_RESULT scale_init(_scale* scale) {
+    memset(scale, 0, sizeof(_scale));
+    pool_init(&scale->pool, "scaler", NES_H, scale_rows, scale);
+    return CNES_SUCCESS;
+}
+
+void scale_deinit(_scale* scale) {
+    pool_deinit(&scale->pool);
+}
+
+CNES_RESULT scale_frame(_scale* scale, _scaler kind, const uint8_t* in, size_t in_pitch, uint8_t* out, size_t out_pitch) {
+    if (kind >= SCALERS || in_pitch < NES_W * sizeof(uint32_t) ||
+        out_pitch < NES_W * SCALER_FACTORS[kind] * sizeof(uint32_t)) {
+        fprintf(stderr, "[ERROR] Invalid scaler parameters!\n");
+        return CNES_FAILURE;
+    }
+
+    load_source(scale, in, in_pitch, kind == SCALER_XBR2X);
+
+    scale->kind = (uint8_t)kind;
+    scale->out = out;
+    scale->out_pitch = out_pitch;
+
+    pool_run(&scale->pool);
+    return CNES_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "cnes.h"
+#include "pool.h"
+#include "ppu.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCALE_PAD       2
+#define SCALE_STRIDE    (NES_W + SCALE_PAD * 2)
+#define SCALE_ROWS      (NES_H + SCALE_PAD * 2)
+#define SCALE_MAX       4
+
+typedef enum _scaler {
+    SCALER_NEAREST2X,
+    SCALER_NEAREST3X,
+    SCALER_NEAREST4X,
+    SCALER_SCALE2X,
+    SCALER_SCALE3X,
+    SCALER_XBR2X,
+    SCALERS
+} _scaler;
+
+static const char* const SCALER_NAMES[SCALERS] = {
+    "NEAREST 2X", "NEAREST 3X", "NEAREST 4X", "SCALE2X", "SCALE3X", "XBR 2X",
+};
+
+static const uint8_t SCALER_FACTORS[SCALERS] = { 2, 3, 4, 2, 3, 2 };
+
+typedef struct _scale {
+    uint32_t src[SCALE_ROWS][SCALE_STRIDE];
+    float yuv[3][SCALE_ROWS][SCALE_STRIDE];
+
+    _pool pool;
+
+    uint8_t kind;
+    uint8_t* out;
+    size_t out_pitch;
+} _scale;
+
+CNES_RESULT scale_init(_scale* scale);
+void scale_deinit(_scale* scale);
+CNES_RESULT scale_frame(_scale* scale, _scaler kind, const uint8_t* in, size_t in_pitch, uint8_t* out, size_t out_pitch);
@@ -0,0 +1,10 @@
+#pragma once
+
+// the vector paths pick one of these; anything else falls back to scalar C
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CNES_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define CNES_NEON
+    #include <arm_neon.h>
+#endif
@@ -0,0 +1,404 @@
+#include "sink.h"
+#include "cnes.h"
+#include "ring.h"
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct _sink_device {
+    SDL_AudioStream* stream;
+    _ring ring;
+    SDL_AtomicInt underruns;
+    uint8_t idle;
+} _sink_device;
+
+static void SDLCALL device_callback(void* data, SDL_AudioStream* stream, int additional, int total) {
+    (void)total;
+    _sink_device* device = (_sink_device*)data;
+    int16_t chunk[SINK_CHUNK];
+    uint32_t want = additional > 0 ? (uint32_t)additional / sizeof(int16_t) : 0;
+    uint32_t asked = want;
+
+    while (want) {
+        uint32_t count = ring_read(&device->ring, chunk, want < SINK_CHUNK ? want : SINK_CHUNK);
+        if (!count) break;
+
+        SDL_PutAudioStreamData(stream, chunk, (int)(count * sizeof(int16_t)));
+        want -= count;
+    }
+
+    // every short callback is an audible gap, but an idle device (nothing fed yet,
+    // cleared, or fully stalled) only counts once
+    if (want && !device->idle) {
+        SDL_AddAtomicInt(&device->underruns, 1);
+    }
+    device->idle = asked && want == asked;
+}
+
+static CNES_RESULT device_open(_sink* sink) {
+    _sink_device* device = (_sink_device*)calloc(1, sizeof(_sink_device));
+    if (!device) return CNES_FAILURE;
+    device->idle = 1;
+
+    SDL_AudioSpec spec;
+    SDL_zero(spec);
+    spec.channels = sink->channels;
+    spec.format = SDL_AUDIO_S16;
+    spec.freq = (int)sink->rate;
+
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, SINK_DEVICE_FRAMES);
+
+    device->stream = SDL_OpenAudioDeviceStream(
+        SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
+        &spec,
+        device_callback,
+        device
+    );
+
+    if (!device->stream) {
+        free(device);
+        return CNES_FAILURE;
+    }
+
+    sink->data = device;
+    SDL_ResumeAudioStreamDevice(device->stream);
+    return CNES_SUCCESS;
+}
+
+static void device_close(_sink* sink) {
+    _sink_device* device = (_sink_device*)sink->data;
+
+    if (device) {
+        SDL_DestroyAudioStream(device->stream);
+        free(device);
+        sink->data = NULL;
+    }
+}
+
+static void device_write(_sink* sink, const int16_t* samples, uint32_t count) {
+    _sink_device* device = (_sink_device*)sink->data;
+
+    if (device) {
+        ring_write(&device->ring, samples, count);
+    }
+}
+
+static void device_clear(_sink* sink) {
+    _sink_device* device = (_sink_device*)sink->data;
+    if (!device) return;
+
+    // the callback is the ring's only reader, hold it off while both ends are reset
+    SDL_LockAudioStream(device->stream);
+    ring_reset(&device->ring);
+    device->idle = 1;
+    SDL_ClearAudioStream(device->stream);
+    SDL_UnlockAudioStream(device->stream);
+}
+
+static int device_queued(_sink* sink) {
+    _sink_device* device = (_sink_device*)sink->data;
+    if (!device) return -1;
+
+    return (int)(ring_count(&device->ring) * sizeof(int16_t)) + SDL_GetAudioStreamQueued(device->stream);
+}
+
+static uint32_t device_underruns(_sink* sink) {
+    _sink_device* device = (_sink_device*)sink->data;
+    return device ? (uint32_t)SDL_GetAtomicInt(&device->underruns) : 0;
+}
+
+static void memory_write(_sink* sink, const int16_t* samples, uint32_t count) {
+    _sink_memory* memory = (_sink_memory*)sink->data;
+
+    if (memory->count + count > memory->capacity) {
+        size_t capacity = memory->capacity ? memory->capacity : 4096;
+        while (capacity < memory->count + count) capacity *= 2;
+
+        int16_t* grown = (int16_t*)realloc(memory->samples, capacity * sizeof(int16_t));
+        if (!grown) {
+            fprintf(stderr, "[ERROR] Failed to grow audio memory sink!\n");
+            return;
+        }
+
+        memory->samples = grown;
+        memory->capacity = capacity;
+    }
+
+    memcpy(memory->samples + memory->count, samples, count * sizeof(int16_t));
+    memory->count += count;
+}
+
+// the emulator fills one block while the writer thread drains the other; a
+// block that fills up before the writer is done grows instead of waiting
+typedef struct _sink_file {
+    FILE* file;
+    uint8_t wav;
+    uint64_t written;
+
+    SDL_Thread* thread;
+    SDL_Mutex* lock;
+    SDL_Condition* wake;
+
+    int16_t* blocks[2];
+    uint32_t counts[2];
+    uint32_t capacities[2];
+    uint8_t filling;
+    uint8_t pending;
+    uint8_t quit;
+} _sink_file;
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void write_wav_header(FILE* out, uint32_t rate, uint8_t channels, uint64_t samples) {
+    uint64_t bytes = samples * sizeof(int16_t);
+    uint32_t data = bytes > UINT32_MAX - 36 ? UINT32_MAX - 36 : (uint32_t)bytes;
+    uint8_t header[44];
+
+    memcpy(header, "RIFF", 4);
+    put_u32(header + 4, 36 + data);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_u32(header + 16, 16);
+    put_u16(header + 20, 1);
+    put_u16(header + 22, channels);
+    put_u32(header + 24, rate);
+    put_u32(header + 28, rate * channels * sizeof(int16_t));
+    put_u16(header + 32, channels * sizeof(int16_t));
+    put_u16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put_u32(header + 40, data);
+
+    fwrite(header, 1, sizeof(header), out);
+}
+
+static void file_flush_block(_sink_file* file, uint8_t block) {
+    fwrite(file->blocks[block], sizeof(int16_t), file->counts[block], file->file);
+    file->written += file->counts[block];
+    file->counts[block] = 0;
+}
+
+static int file_worker(void* data) {
+    _sink_file* file = (_sink_file*)data;
+
+    SDL_LockMutex(file->lock);
+
+    while (!file->quit || file->pending) {
+        if (!file->pending) {
+            SDL_WaitCondition(file->wake, file->lock);
+            continue;
+        }
+
+        uint8_t block = file->filling ^ 1;
+        SDL_UnlockMutex(file->lock);
+
+        file_flush_block(file, block);
+
+        SDL_LockMutex(file->lock);
+        file->pending = 0;
+    }
+
+    SDL_UnlockMutex(file->lock);
+    return 0;
+}
+
+static void file_close(_sink* sink) {
+    _sink_file* file = (_sink_file*)sink->data;
+    if (!file) return;
+
+    if (file->thread) {
+        SDL_LockMutex(file->lock);
+        file->quit = 1;
+        SDL_SignalCondition(file->wake);
+        SDL_UnlockMutex(file->lock);
+
+        SDL_WaitThread(file->thread, NULL);
+    }
+
+    if (file->file) {
+        file_flush_block(file, file->filling);
+
+        if (file->wav && fseek(file->file, 0, SEEK_SET) == 0) {
+            write_wav_header(file->file, sink->rate, sink->channels, file->written);
+        }
+
+        fclose(file->file);
+    }
+
+    if (file->wake) SDL_DestroyCondition(file->wake);
+    if (file->lock) SDL_DestroyMutex(file->lock);
+
+    free(file->blocks[0]);
+    free(file->blocks[1]);
+    free(file);
+    sink->data = NULL;
+}
+
+static CNES_RESULT file_open(_sink* sink) {
+    _sink_file* file = (_sink_file*)calloc(1, sizeof(_sink_file));
+    if (!file) return CNES_FAILURE;
+
+    sink->data = file;
+
+    const char* ext = strrchr(sink->path, '.');
+    file->wav = ext && SDL_strcasecmp(ext, ".wav") == 0;
+
+    file->file = fopen(sink->path, "wb");
+    if (!file->file) {
+        fprintf(stderr, "[ERROR] Failed to open audio file %s!\n", sink->path);
+        file_close(sink);
+        return CNES_FAILURE;
+    }
+
+    if (file->wav) {
+        write_wav_header(file->file, sink->rate, sink->channels, 0);
+    }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        file->capacities[i] = 2 * SINK_BLOCK;
+        file->blocks[i] = (int16_t*)malloc(file->capacities[i] * sizeof(int16_t));
+    }
+
+    file->lock = SDL_CreateMutex();
+    file->wake = SDL_CreateCondition();
+
+    if (!file->blocks[0] || !file->blocks[1] || !file->lock || !file->wake) {
+        file_close(sink);
+        return CNES_FAILURE;
+    }
+
+    file->thread = SDL_CreateThread(file_worker, "cnes audio writer", file);
+    if (!file->thread) {
+        file_close(sink);
+        return CNES_FAILURE;
+    }
+
+    return CNES_SUCCESS;
+}
+
+static void file_write(_sink* sink, const int16_t* samples, uint32_t count) {
+    _sink_file* file = (_sink_file*)sink->data;
+    uint8_t block = file->filling;
+
+    if (file->counts[block] + count > file->capacities[block]) {
+        uint32_t capacity = file->capacities[block];
+        while (capacity < file->counts[block] + count) capacity *= 2;
+
+        int16_t* grown = (int16_t*)realloc(file->blocks[block], capacity * sizeof(int16_t));
+        if (!grown) {
+            fprintf(stderr, "[ERROR] Failed to grow audio file buffer!\n");
+            return;
+        }
+
+        file->blocks[block] = grown;
+        file->capacities[block] = capacity;
+    }
+
+    memcpy(file->blocks[block] + file->counts[block], samples, count * sizeof(int16_t));
+    file->counts[block] += count;
+
+    if (file->counts[block] < SINK_BLOCK) return;
+
+    SDL_LockMutex(file->lock);
+    if (!file->pending) {
+        file->pending = 1;
+        file->filling ^= 1;
+        SDL_SignalCondition(file->wake);
+    }
+    SDL_UnlockMutex(file->lock);
+}
+
+_sink sink_device(void) {
+    return (_sink){
+        .kind = SINK_DEVICE,
+        .open = device_open,
+        .close = device_close,
+        .write = device_write,
+        .clear = device_clear,
+        .queued = device_queued,
+        .underruns = device_underruns,
+    };
+}
+
+_sink sink_null(void) {
+    return (_sink){ .kind = SINK_NULL };
+}
+
+_sink sink_memory(_sink_memory* memory) {
+    return (_sink){
+        .kind = SINK_MEMORY,
+        .data = memory,
+        .write = memory_write,
+    };
+}
+
+_sink sink_file(const char* path) {
+    return (_sink){
+        .kind = SINK_FILE,
+        .path = path,
+        .open = file_open,
+        .close = file_close,
+        .write = file_write,
+    };
+}
+
+CNES_RESULT sink_open(_sink* sink, uint32_t rate) {
+    sink->rate = rate;
+    sink->retry = 0;
+    if (!sink->channels) sink->channels = 1;
+
+    if (sink->open && sink->open(sink) != CNES_SUCCESS) {
+        return CNES_FAILURE;
+    }
+
+    sink->active = 1;
+    return CNES_SUCCESS;
+}
+
+void sink_close(_sink* sink) {
+    if (sink->active && sink->close) {
+        sink->close(sink);
+    }
+    sink->active = 0;
+    sink->retry = 0;
+}
+
+void sink_retry(_sink* sink, uint32_t rate) {
+    sink->rate = rate;
+    sink->active = 0;
+    sink->retry = SINK_RETRY_FRAMES;
+}
+
+void sink_write(_sink* sink, const int16_t* samples, uint32_t count) {
+    if (!count) return;
+
+    if (!sink->active && sink->retry && --sink->retry == 0 &&
+        sink_open(sink, sink->rate) != CNES_SUCCESS) {
+        sink->retry = SINK_RETRY_FRAMES;
+    }
+
+    if (sink->active && sink->write) {
+        sink->write(sink, samples, count);
+    }
+}
+
+void sink_clear(_sink* sink) {
+    if (sink->active && sink->clear) {
+        sink->clear(sink);
+    }
+}
+
+int sink_queued(_sink* sink) {
+    return sink->active && sink->queued ? sink->queued(sink) : -1;
+}
+
+uint32_t sink_underruns(_sink* sink) {
+    return sink->active && sink->underruns ? sink->underruns(sink) : 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "cnes.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define SINK_RETRY_FRAMES 120
+#define SINK_CHUNK 256
+#define SINK_DEVICE_FRAMES "256"
+#define SINK_BLOCK 65536
+
+typedef enum _sink_kind {
+    SINK_DEVICE,
+    SINK_NULL,
+    SINK_MEMORY,
+    SINK_FILE,
+    SINK_CUSTOM,
+    SINKS
+} _sink_kind;
+
+typedef struct _sink _sink;
+
+// any callback may be NULL; queued() and underruns() are only set by sinks that play back in realtime
+// counts are in samples, multichannel sinks take them interleaved
+typedef struct _sink {
+    _sink_kind kind;
+    void* data;
+    const char* path;
+    uint32_t rate;
+    uint8_t channels;
+    uint8_t active;
+    uint8_t retry;
+
+    CNES_RESULT (*open)(_sink* sink);
+    void (*close)(_sink* sink);
+    void (*write)(_sink* sink, const int16_t* samples, uint32_t count);
+    void (*clear)(_sink* sink);
+    int (*queued)(_sink* sink);
+    uint32_t (*underruns)(_sink* sink);
+} _sink;
+
+typedef struct _sink_memory {
+    int16_t* samples;
+    size_t count;
+    size_t capacity;
+} _sink_memory;
+
+_sink sink_device(void);
+_sink sink_null(void);
+_sink sink_memory(_sink_memory* memory);
+// recorded on a writer thread, as WAV when the path ends in .wav and raw s16 otherwise
+_sink sink_file(const char* path);
+
+CNES_RESULT sink_open(_sink* sink, uint32_t rate);
+void sink_close(_sink* sink);
+// keeps a sink that failed to open and tries again every SINK_RETRY_FRAMES writes
+void sink_retry(_sink* sink, uint32_t rate);
+void sink_write(_sink* sink, const int16_t* samples, uint32_t count);
+void sink_clear(_sink* sink);
+int sink_queued(_sink* sink);
+uint32_t sink_underruns(_sink* sink);
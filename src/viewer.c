@@ -0,0 +1,594 @@
+#include "viewer.h"
+#include "cart.h"
+#include "cnes.h"
+#include "ppu.h"
+#include <dcimgui.h>
+#include <backends/dcimgui_impl_sdlgpu3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NTBL_KEY_VALID  0x8000
+
+static const char* VIEWER_NAMES[VIEWERS] = {
+    "NAMETABLES",
+    "PATTERN TABLES",
+    "PALETTE",
+    "OAM",
+    "EVENTS",
+};
+
+static const char* LOG_KIND_NAMES[LOG_KINDS] = {
+    "PPU",
+    "APU",
+    "MAPPER",
+};
+
+static const ImU32 LOG_KIND_COLORS[LOG_KINDS] = {
+    IM_COL32(0xFF, 0x50, 0x50, 0xFF),
+    IM_COL32(0x50, 0xFF, 0x50, 0xFF),
+    IM_COL32(0x50, 0xA0, 0xFF, 0xFF),
+};
+
+static const char* PPU_REG_NAMES[8] = {
+    "PPUCTRL", "PPUMASK", "PPUSTATUS", "OAMADDR",
+    "OAMDATA", "PPUSCROLL", "PPUADDR", "PPUDATA",
+};
+
+static void view_tex_release(_view_tex* tex, SDL_GPUDevice* device) {
+    if (tex->transfer) SDL_ReleaseGPUTransferBuffer(device, tex->transfer);
+    if (tex->texture) SDL_ReleaseGPUTexture(device, tex->texture);
+    free(tex->pixels);
+    free(tex->dirty_rows);
+    memset(tex, 0, sizeof(_view_tex));
+}
+
+static CNES_RESULT view_tex_create(_view_tex* tex, SDL_GPUDevice* device, uint16_t w, uint16_t h) {
+    if (tex->texture) return CNES_SUCCESS;
+
+    const SDL_GPUTextureCreateInfo tinfo = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .width = w,
+        .height = h,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+    };
+
+    const SDL_GPUTransferBufferCreateInfo transfer_buffer = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = (uint32_t)w * h * sizeof(uint32_t),
+    };
+
+    tex->texture = SDL_CreateGPUTexture(device, &tinfo);
+    tex->transfer = SDL_CreateGPUTransferBuffer(device, &transfer_buffer);
+    tex->pixels = (uint32_t*)calloc((size_t)w * h, sizeof(uint32_t));
+    tex->dirty_rows = (uint8_t*)calloc(h / 8, sizeof(uint8_t));
+
+    if (!tex->texture || !tex->transfer || !tex->pixels || !tex->dirty_rows) {
+        fprintf(stderr, "[ERROR] Failed to create debug viewer texture: %s\n", SDL_GetError());
+        view_tex_release(tex, device);
+        return CNES_FAILURE;
+    }
+
+    tex->w = w;
+    tex->h = h;
+    tex->stale = 1;
+
+    return CNES_SUCCESS;
+}
+
+static void view_tex_upload(_view_tex* tex, SDL_GPUDevice* device, SDL_GPUCopyPass* copy) {
+    uint16_t strips = tex->h / 8;
+    uint16_t first = 0;
+
+    while (first < strips && !tex->dirty_rows[first]) first++;
+    if (first == strips) return;
+
+    uint8_t* dst = (uint8_t*)SDL_MapGPUTransferBuffer(device, tex->transfer, true);
+    if (!dst) return;
+
+    size_t stride = (size_t)tex->w * sizeof(uint32_t);
+
+    for (uint16_t s = first; s < strips; s++) {
+        if (tex->dirty_rows[s]) {
+            memcpy(dst + s * 8 * stride, tex->pixels + s * 8 * tex->w, 8 * stride);
+        }
+    }
+
+    SDL_UnmapGPUTransferBuffer(device, tex->transfer);
+
+    for (uint16_t s = first; s < strips;) {
+        if (!tex->dirty_rows[s]) {
+            s++;
+            continue;
+        }
+
+        uint16_t end = s;
+        while (end < strips && tex->dirty_rows[end]) {
+            tex->dirty_rows[end++] = 0;
+        }
+
+        const SDL_GPUTextureTransferInfo xfer = {
+            .transfer_buffer = tex->transfer,
+            .offset = (uint32_t)(s * 8 * stride),
+            .pixels_per_row = tex->w,
+            .rows_per_layer = (uint32_t)(end - s) * 8,
+        };
+        const SDL_GPUTextureRegion region = {
+            .texture = tex->texture,
+            .mip_level = 0,
+            .layer = 0,
+            .x = 0,
+            .y = (uint32_t)s * 8,
+            .z = 0,
+            .w = tex->w,
+            .h = (uint32_t)(end - s) * 8,
+            .d = 1,
+        };
+        SDL_UploadToGPUTexture(copy, &xfer, &region, false);
+
+        s = end;
+    }
+}
+
+static void draw_tile(_view_tex* tex, const uint8_t* chr, uint16_t tile, uint32_t* colors,
+                      uint16_t x, uint16_t y) {
+    const uint8_t* plane = chr + (tile & (CHR_TILES - 1)) * 16;
+
+    for (uint8_t row = 0; row < 8; row++) {
+        uint8_t low = plane[row];
+        uint8_t high = plane[row + 8];
+        uint32_t* out = tex->pixels + (y + row) * tex->w + x;
+
+        for (uint8_t col = 0; col < 8; col++) {
+            uint8_t bit = 7 - col;
+            uint8_t pixel = (uint8_t)((((high >> bit) & 1) << 1) | ((low >> bit) & 1));
+            out[col] = colors[pixel];
+        }
+    }
+
+    tex->dirty_rows[y / 8] = 1;
+}
+
+static void tile_colors(_viewers* viewers, uint8_t palette, uint32_t colors[4]) {
+    colors[0] = viewers->palette[0];
+    colors[1] = viewers->palette[(palette << 2) | 1];
+    colors[2] = viewers->palette[(palette << 2) | 2];
+    colors[3] = viewers->palette[(palette << 2) | 3];
+}
+
+static void update_chr(_viewers* viewers, _cart* cart) {
+    const uint8_t* source = cart->chr_rom.data ? cart->chr_rom.data : cart->chr_ram.data;
+
+    if (viewers->chr_valid && viewers->chr_source == source && viewers->chr_gen == cart->chr_gen) {
+        return;
+    }
+
+    uint8_t full = !viewers->chr_valid || viewers->chr_source != source;
+
+    for (uint16_t tile = 0; tile < CHR_TILES; tile++) {
+        uint8_t* shadow = viewers->chr_shadow + tile * 16;
+        uint8_t changed = full;
+
+        for (uint8_t i = 0; i < 16; i++) {
+            uint8_t data = cart_ppu_read(cart, (uint16_t)(tile * 16 + i));
+            changed |= shadow[i] != data;
+            shadow[i] = data;
+        }
+
+        viewers->chr_dirty[tile] |= changed;
+    }
+
+    viewers->chr_source = source;
+    viewers->chr_gen = cart->chr_gen;
+    viewers->chr_valid = 1;
+}
+
+static void update_palette(_viewers* viewers, _ppu* ppu) {
+    if (memcmp(viewers->palette, ppu->palette_rgba, sizeof(viewers->palette)) != 0) {
+        memcpy(viewers->palette, ppu->palette_rgba, sizeof(viewers->palette));
+        viewers->palette_dirty = 1;
+    }
+}
+
+static void update_pattern_view(_viewers* viewers) {
+    _view_tex* tex = &viewers->chr;
+
+    uint8_t full = tex->stale || viewers->palette_dirty ||
+                   viewers->chr_palette != viewers->chr_palette_drawn;
+
+    uint32_t colors[4];
+    tile_colors(viewers, (uint8_t)viewers->chr_palette, colors);
+
+    for (uint16_t tile = 0; tile < CHR_TILES; tile++) {
+        if (!full && !viewers->chr_dirty[tile]) continue;
+
+        uint16_t x = (tile >> 8) * 128 + (tile & 0x0F) * 8;
+        uint16_t y = ((tile >> 4) & 0x0F) * 8;
+        draw_tile(tex, viewers->chr_shadow, tile, colors, x, y);
+    }
+
+    viewers->chr_palette_drawn = viewers->chr_palette;
+    tex->stale = 0;
+}
+
+static void update_nametable_view(_viewers* viewers, _ppu* ppu, _cart* cart) {
+    _view_tex* tex = &viewers->ntbl;
+
+    uint8_t bgrnd_sel = ppu->ppuctrl & BGRND_SEL;
+    uint8_t full = tex->stale || viewers->palette_dirty || viewers->bgrnd_sel != bgrnd_sel;
+    uint16_t base = bgrnd_sel ? 0x100 : 0x000;
+
+    for (uint8_t page = 0; page < 4; page++) {
+        uint8_t* ntbl = cart->ntbl[page];
+        uint16_t* keys = viewers->ntbl_key[page];
+        if (!ntbl) continue;
+
+        if (full || viewers->ntbl_page[page] != ntbl) {
+            memset(keys, 0, sizeof(viewers->ntbl_key[page]));
+            viewers->ntbl_page[page] = ntbl;
+        }
+
+        uint16_t origin_x = (page & 1) * NES_W;
+        uint16_t origin_y = (page >> 1) * NES_H;
+
+        for (uint16_t i = 0; i < 30 * 32; i++) {
+            uint8_t tx = i & 0x1F;
+            uint8_t ty = (uint8_t)(i >> 5);
+
+            uint8_t id = ntbl[i];
+            uint8_t attr = ntbl[0x3C0 + (ty >> 2) * 8 + (tx >> 2)];
+            uint8_t palette = (attr >> (((ty & 0x02) << 1) | (tx & 0x02))) & 0x03;
+
+            uint16_t key = NTBL_KEY_VALID | (uint16_t)(palette << 8) | id;
+            if (keys[i] == key && !viewers->chr_dirty[base + id]) continue;
+            keys[i] = key;
+
+            uint32_t colors[4];
+            tile_colors(viewers, palette, colors);
+            draw_tile(tex, viewers->chr_shadow, base + id, colors, origin_x + tx * 8, origin_y + ty * 8);
+        }
+    }
+
+    viewers->bgrnd_sel = bgrnd_sel;
+    tex->stale = 0;
+}
+
+static void update_oam_view(_viewers* viewers, _ppu* ppu) {
+    _view_tex* tex = &viewers->oam;
+
+    uint8_t sprite_ctrl = ppu->ppuctrl & (SPRITE_SEL | SPRITE_HEIGHT);
+    uint8_t full = tex->stale || viewers->palette_dirty || viewers->sprite_ctrl != sprite_ctrl;
+
+    for (uint8_t i = 0; i < 0x40; i++) {
+        _sprite* sprite = &ppu->oam[i];
+        _sprite* shadow = &viewers->oam_shadow[i];
+
+        uint16_t top;
+        uint16_t bottom;
+        if (sprite_ctrl & SPRITE_HEIGHT) {
+            top = (uint16_t)((sprite->id & 0x01) << 8) | (sprite->id & 0xFE);
+            bottom = top + 1;
+        } else {
+            top = (uint16_t)((sprite_ctrl & SPRITE_SEL) << 5) | sprite->id;
+            bottom = 0;
+        }
+
+        uint8_t changed = full || shadow->id != sprite->id ||
+                          (shadow->attr & SPRITE_PALETTE) != (sprite->attr & SPRITE_PALETTE) ||
+                          viewers->chr_dirty[top] ||
+                          ((sprite_ctrl & SPRITE_HEIGHT) && viewers->chr_dirty[bottom]);
+        *shadow = *sprite;
+        if (!changed) continue;
+
+        uint32_t colors[4];
+        tile_colors(viewers, (sprite->attr & SPRITE_PALETTE) + 0x04, colors);
+
+        uint16_t x = (i & 0x07) * 8;
+        uint16_t y = (i >> 3) * 16;
+        draw_tile(tex, viewers->chr_shadow, top, colors, x, y);
+
+        if (sprite_ctrl & SPRITE_HEIGHT) {
+            draw_tile(tex, viewers->chr_shadow, bottom, colors, x, y + 8);
+        } else {
+            uint32_t* out = tex->pixels + (y + 8) * tex->w + x;
+            for (uint8_t row = 0; row < 8; row++, out += tex->w) {
+                for (uint8_t col = 0; col < 8; col++) out[col] = 0;
+            }
+            tex->dirty_rows[y / 8 + 1] = 1;
+        }
+    }
+
+    viewers->sprite_ctrl = sprite_ctrl;
+    tex->stale = 0;
+}
+
+void viewer_update(_viewers* viewers, SDL_GPUDevice* device, SDL_GPUCommandBuffer* cmdbuf, _nes* nes) {
+    uint8_t any_open = 0;
+
+    nes_set_reglog(nes, viewers->open[VIEWER_EVENTS]);
+
+    for (uint8_t i = 0; i < VIEWERS; i++) {
+        if (viewers->open[i] && !viewers->was_open[i]) {
+            if (i == VIEWER_NAMETABLE) viewers->ntbl.stale = 1;
+            if (i == VIEWER_PATTERN) viewers->chr.stale = 1;
+            if (i == VIEWER_OAM) viewers->oam.stale = 1;
+        }
+        viewers->was_open[i] = viewers->open[i];
+        any_open |= viewers->open[i];
+    }
+
+    if (!any_open || !nes->cart.loaded) return;
+
+    _ppu* ppu = &nes->ppu;
+    _cart* cart = &nes->cart;
+
+    update_palette(viewers, ppu);
+
+    uint8_t needs_chr = viewers->open[VIEWER_NAMETABLE] || viewers->open[VIEWER_PATTERN] ||
+                        viewers->open[VIEWER_OAM];
+
+    viewers->chr_blocked = cart->ppu_snoop;
+    if (needs_chr && !viewers->chr_blocked) {
+        update_chr(viewers, cart);
+
+        if (viewers->open[VIEWER_PATTERN]) {
+            if (view_tex_create(&viewers->chr, device, CHR_VIEW_W, CHR_VIEW_H) == CNES_SUCCESS) {
+                update_pattern_view(viewers);
+            } else {
+                viewers->open[VIEWER_PATTERN] = false;
+            }
+        }
+
+        if (viewers->open[VIEWER_NAMETABLE]) {
+            if (view_tex_create(&viewers->ntbl, device, NTBL_VIEW_W, NTBL_VIEW_H) == CNES_SUCCESS) {
+                update_nametable_view(viewers, ppu, cart);
+            } else {
+                viewers->open[VIEWER_NAMETABLE] = false;
+            }
+        }
+
+        if (viewers->open[VIEWER_OAM]) {
+            if (view_tex_create(&viewers->oam, device, OAM_VIEW_W, OAM_VIEW_H) == CNES_SUCCESS) {
+                update_oam_view(viewers, ppu);
+            } else {
+                viewers->open[VIEWER_OAM] = false;
+            }
+        }
+
+        memset(viewers->chr_dirty, 0, sizeof(viewers->chr_dirty));
+    }
+
+    viewers->palette_dirty = 0;
+
+    if (!viewers->ntbl.texture && !viewers->chr.texture && !viewers->oam.texture) return;
+
+    SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass(cmdbuf);
+    if (!copy) return;
+
+    if (viewers->open[VIEWER_NAMETABLE] && viewers->ntbl.texture) view_tex_upload(&viewers->ntbl, device, copy);
+    if (viewers->open[VIEWER_PATTERN] && viewers->chr.texture) view_tex_upload(&viewers->chr, device, copy);
+    if (viewers->open[VIEWER_OAM] && viewers->oam.texture) view_tex_upload(&viewers->oam, device, copy);
+
+    SDL_EndGPUCopyPass(copy);
+}
+
+static void set_sampler(const ImDrawList* parent_list, const ImDrawCmd* cmd) {
+    (void)parent_list;
+    ImGui_ImplSDLGPU3_RenderState* state = (ImGui_ImplSDLGPU3_RenderState*)ImGui_GetPlatformIO()->Renderer_RenderState;
+    state->SamplerCurrent = (SDL_GPUSampler*)cmd->UserCallbackData;
+}
+
+static void draw_texture(_view_tex* tex, SDL_GPUSampler* sampler, float scale) {
+    if (!tex->texture) return;
+
+    ImTextureRef ref = { ._TexData = NULL, ._TexID = (ImTextureID)(uintptr_t)tex->texture };
+    ImDrawList* draw_list = ImGui_GetWindowDrawList();
+
+    ImDrawList_AddCallback(draw_list, set_sampler, sampler);
+    ImGui_Image(ref, (ImVec2){ tex->w * scale, tex->h * scale });
+    ImDrawList_AddCallback(draw_list, ImDrawCallback_ResetRenderState, NULL);
+}
+
+static uint8_t chr_unavailable(_viewers* viewers) {
+    if (!viewers->chr_blocked) return 0;
+    ImGui_TextDisabled("CHR VIEWS UNAVAILABLE FOR THIS MAPPER");
+    return 1;
+}
+
+static ImVec4 rgba_to_vec4(uint32_t color) {
+    return (ImVec4){
+        (float)(color & 0xFF) / 255.0f,
+        (float)((color >> 8) & 0xFF) / 255.0f,
+        (float)((color >> 16) & 0xFF) / 255.0f,
+        1.0f,
+    };
+}
+
+static void draw_palette(_ppu* ppu) {
+    char id[16];
+
+    for (uint8_t i = 0; i < 0x20; i++) {
+        if (i & 0x0F) ImGui_SameLine();
+
+        snprintf(id, sizeof(id), "$%02X: $%02X", 0x3F00 + i, ppu->palette_idx[i]);
+        ImGui_ColorButtonEx(id, rgba_to_vec4(ppu->palette_rgba[i]), ImGuiColorEditFlags_NoAlpha,
+                            (ImVec2){ 16.0f, 16.0f });
+    }
+}
+
+static _log_kind log_kind(uint16_t addr) {
+    if (addr < 0x4000) return LOG_PPU;
+    if (addr <= 0x4017) return LOG_APU;
+    return LOG_MAPPER;
+}
+
+static void log_reg_name(uint16_t addr, char* name, size_t size) {
+    if (addr < 0x4000) {
+        snprintf(name, size, "%s", PPU_REG_NAMES[addr & 0x07]);
+    } else if (addr == OAMDMA) {
+        snprintf(name, size, "OAMDMA");
+    } else {
+        snprintf(name, size, "$%04X", addr);
+    }
+}
+
+static void draw_event_timeline(_viewers* viewers, _reglog* log, uint32_t rows) {
+    const float scale = 2.0f;
+    const float w = (NES_ALL_WMAX + 1) * scale;
+    const float h = (NES_ALL_HMAX + 1) * scale;
+
+    ImDrawList* draw_list = ImGui_GetWindowDrawList();
+    ImVec2 origin = ImGui_GetCursorScreenPos();
+
+    ImDrawList_AddRectFilled(draw_list, origin, (ImVec2){ origin.x + w, origin.y + h },
+                             IM_COL32(0x20, 0x20, 0x20, 0xFF));
+    ImDrawList_AddRectFilled(draw_list,
+                             (ImVec2){ origin.x + scale, origin.y },
+                             (ImVec2){ origin.x + (NES_W + 1) * scale, origin.y + NES_H * scale },
+                             IM_COL32(0x40, 0x40, 0x40, 0xFF));
+
+    for (uint32_t i = 0; i < rows; i++) {
+        const _reglog_entry* entry = reglog_frame_entry(log, viewers->log_rows[i]);
+        ImVec2 p = { origin.x + entry->dot * scale, origin.y + entry->scanline * scale };
+        ImDrawList_AddRectFilled(draw_list, p, (ImVec2){ p.x + scale, p.y + scale },
+                                 LOG_KIND_COLORS[log_kind(entry->addr)]);
+    }
+
+    ImGui_Dummy((ImVec2){ w, h });
+
+    if (!ImGui_IsItemHovered(0)) return;
+
+    ImVec2 mouse = ImGui_GetMousePos();
+    int dot = (int)((mouse.x - origin.x) / scale);
+    int line = (int)((mouse.y - origin.y) / scale);
+
+    for (uint32_t i = 0; i < rows; i++) {
+        const _reglog_entry* entry = reglog_frame_entry(log, viewers->log_rows[i]);
+        if (entry->scanline != line || abs((int)entry->dot - dot) > 2) continue;
+
+        char name[16];
+        log_reg_name(entry->addr, name, sizeof(name));
+        ImGui_SetTooltip("LINE %d DOT %d\nPC $%04X\n%s = $%02X",
+                         entry->scanline, entry->dot, entry->pc, name, entry->data);
+        break;
+    }
+}
+
+static void draw_event_log(_viewers* viewers, _nes* nes) {
+    _reglog* log = &nes->reglog;
+    if (!log->entries) return;
+
+    for (uint8_t k = 0; k < LOG_KINDS; k++) {
+        bool show = !viewers->log_hide[k];
+        if (k) ImGui_SameLine();
+        if (ImGui_Checkbox(LOG_KIND_NAMES[k], &show)) viewers->log_hide[k] = !show;
+    }
+
+    uint32_t count = reglog_frame_count(log);
+    uint32_t rows = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (viewers->log_hide[log_kind(reglog_frame_entry(log, i)->addr)]) continue;
+        viewers->log_rows[rows++] = (uint16_t)i;
+    }
+
+    ImGui_Text("%u WRITES", rows);
+    draw_event_timeline(viewers, log, rows);
+
+    ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter;
+    if (!ImGui_BeginTableEx("EventTable", 5, flags, (ImVec2){ (NES_ALL_WMAX + 1) * 2.0f, 200.0f }, 0.0f)) {
+        return;
+    }
+
+    ImGui_TableSetupScrollFreeze(0, 1);
+    ImGui_TableSetupColumn("LINE", 0);
+    ImGui_TableSetupColumn("DOT", 0);
+    ImGui_TableSetupColumn("PC", 0);
+    ImGui_TableSetupColumn("REG", 0);
+    ImGui_TableSetupColumn("DATA", 0);
+    ImGui_TableHeadersRow();
+
+    ImGuiListClipper clipper;
+    memset(&clipper, 0, sizeof(clipper));
+    ImGuiListClipper_Begin(&clipper, (int)rows, -1.0f);
+
+    while (ImGuiListClipper_Step(&clipper)) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const _reglog_entry* entry = reglog_frame_entry(log, viewers->log_rows[i]);
+            char name[16];
+            log_reg_name(entry->addr, name, sizeof(name));
+
+            ImGui_TableNextRow();
+            ImGui_TableNextColumn();
+            ImGui_Text("%d", entry->scanline);
+            ImGui_TableNextColumn();
+            ImGui_Text("%d", entry->dot);
+            ImGui_TableNextColumn();
+            ImGui_Text("$%04X", entry->pc);
+            ImGui_TableNextColumn();
+            ImGui_TextColored(ImGui_ColorConvertU32ToFloat4(LOG_KIND_COLORS[log_kind(entry->addr)]), "%s", name);
+            ImGui_TableNextColumn();
+            ImGui_Text("$%02X", entry->data);
+        }
+    }
+
+    ImGui_EndTable();
+}
+
+void viewer_draw(_viewers* viewers, SDL_GPUSampler* sampler, _nes* nes) {
+    if (viewers->open[VIEWER_NAMETABLE]) {
+        if (ImGui_Begin(VIEWER_NAMES[VIEWER_NAMETABLE], &viewers->open[VIEWER_NAMETABLE], ImGuiWindowFlags_AlwaysAutoResize)) {
+            if (!chr_unavailable(viewers)) draw_texture(&viewers->ntbl, sampler, 1.0f);
+        }
+        ImGui_End();
+    }
+
+    if (viewers->open[VIEWER_PATTERN]) {
+        if (ImGui_Begin(VIEWER_NAMES[VIEWER_PATTERN], &viewers->open[VIEWER_PATTERN], ImGuiWindowFlags_AlwaysAutoResize)) {
+            if (!chr_unavailable(viewers)) {
+                draw_texture(&viewers->chr, sampler, 2.0f);
+                ImGui_SetNextItemWidth(CHR_VIEW_W * 2.0f);
+                ImGui_SliderInt("PALETTE", &viewers->chr_palette, 0, 7);
+            }
+        }
+        ImGui_End();
+    }
+
+    if (viewers->open[VIEWER_PALETTE]) {
+        if (ImGui_Begin(VIEWER_NAMES[VIEWER_PALETTE], &viewers->open[VIEWER_PALETTE], ImGuiWindowFlags_AlwaysAutoResize)) {
+            draw_palette(&nes->ppu);
+        }
+        ImGui_End();
+    }
+
+    if (viewers->open[VIEWER_OAM]) {
+        if (ImGui_Begin(VIEWER_NAMES[VIEWER_OAM], &viewers->open[VIEWER_OAM], ImGuiWindowFlags_AlwaysAutoResize)) {
+            if (!chr_unavailable(viewers)) draw_texture(&viewers->oam, sampler, 3.0f);
+        }
+        ImGui_End();
+    }
+
+    if (viewers->open[VIEWER_EVENTS]) {
+        if (ImGui_Begin(VIEWER_NAMES[VIEWER_EVENTS], &viewers->open[VIEWER_EVENTS], ImGuiWindowFlags_AlwaysAutoResize)) {
+            draw_event_log(viewers, nes);
+        }
+        ImGui_End();
+    }
+}
+
+void viewer_menu(_viewers* viewers) {
+    for (uint8_t i = 0; i < VIEWERS; i++) {
+        ImGui_MenuItemBoolPtr(VIEWER_NAMES[i], NULL, &viewers->open[i], true);
+    }
+}
+
+void viewer_deinit(_viewers* viewers, SDL_GPUDevice* device) {
+    view_tex_release(&viewers->ntbl, device);
+    view_tex_release(&viewers->chr, device);
+    view_tex_release(&viewers->oam, device);
+    viewers->chr_valid = 0;
+}
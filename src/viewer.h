@@ -0,0 +1,78 @@
+#pragma once
+#include "cnes.h"
+#include "nes.h"
+#include "reglog.h"
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CHR_TILES       0x200
+#define NTBL_VIEW_W     (NES_W * 2)
+#define NTBL_VIEW_H     (NES_H * 2)
+#define CHR_VIEW_W      256
+#define CHR_VIEW_H      128
+#define OAM_VIEW_W      64
+#define OAM_VIEW_H      128
+
+typedef enum _viewer_kind {
+    VIEWER_NAMETABLE,
+    VIEWER_PATTERN,
+    VIEWER_PALETTE,
+    VIEWER_OAM,
+    VIEWER_EVENTS,
+    VIEWERS,
+} _viewer_kind;
+
+typedef enum _log_kind {
+    LOG_PPU,
+    LOG_APU,
+    LOG_MAPPER,
+    LOG_KINDS,
+} _log_kind;
+
+typedef struct _view_tex {
+    SDL_GPUTexture* texture;
+    SDL_GPUTransferBuffer* transfer;
+    uint32_t* pixels;
+    uint16_t w;
+    uint16_t h;
+    uint8_t* dirty_rows;
+    uint8_t stale;
+} _view_tex;
+
+typedef struct _viewers {
+    bool open[VIEWERS];
+    bool was_open[VIEWERS];
+
+    _view_tex ntbl;
+    _view_tex chr;
+    _view_tex oam;
+
+    const uint8_t* chr_source;
+    uint32_t chr_gen;
+    uint8_t chr_valid;
+    uint8_t chr_blocked;
+    uint8_t chr_shadow[CHR_TILES * 16];
+    uint8_t chr_dirty[CHR_TILES];
+
+    uint32_t palette[0x20];
+    uint8_t palette_dirty;
+    int chr_palette;
+    int chr_palette_drawn;
+
+    uint8_t* ntbl_page[4];
+    uint16_t ntbl_key[4][30 * 32];
+    uint8_t bgrnd_sel;
+
+    _sprite oam_shadow[0x40];
+    uint8_t sprite_ctrl;
+
+    bool log_hide[LOG_KINDS];
+    uint16_t log_rows[REGLOG_CAPACITY];
+} _viewers;
+
+void viewer_update(_viewers* viewers, SDL_GPUDevice* device, SDL_GPUCommandBuffer* cmdbuf, _nes* nes);
+void viewer_draw(_viewers* viewers, SDL_GPUSampler* sampler, _nes* nes);
+void viewer_menu(_viewers* viewers);
+void viewer_deinit(_viewers* viewers, SDL_GPUDevice* device);